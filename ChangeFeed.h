@@ -0,0 +1,219 @@
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+// One change to the teams of a Plains
+struct ChangeEvent {
+    enum Type {
+        RECORD_CHANGED = 1,     // m_team's record changed by m_value
+        TEAMS_MERGED = 2,       // m_other was merged into m_team, new record m_value
+        TEAM_RETIRED = 3        // m_team no longer exists (its ID cannot come back)
+    };
+
+    int m_type;
+    int m_team;
+    int m_other;
+    int m_value;
+};
+
+// Broadcast change feed: a single producer (the Plains thread) appends
+// events to a fixed ring, and any number of subscribers read them at their
+// own pace from other threads without locks.
+//
+// Every slot carries a sequence stamp that is odd while the slot is being
+// written, so readers detect torn or overwritten events and retry or skip.
+// The producer never waits: a subscriber that falls more than the capacity
+// behind loses the oldest events and is told how many it missed.
+// With no subscribers publish is a single relaxed load.
+class ChangeFeed {
+private:
+    struct Slot {
+        std::atomic<uint64_t> m_stamp;     // 2 * sequence + 2 once written
+        std::atomic<uint64_t> m_words[2];  // Packed ChangeEvent
+    };
+
+    Slot* m_slots;
+    uint64_t m_mask;
+
+    // Keeps the producer's counter off the line of the read-only fields
+    // (no alignas: the feed is heap allocated and C++11 new ignores it)
+    char m_padding[64];
+    std::atomic<uint64_t> m_head;   // Sequence of the next event
+    std::atomic<int> m_subscribers;
+
+    static uint64_t pack(int high, int low) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(high)) << 32) | static_cast<uint32_t>(low);
+    }
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit ChangeFeed(int capacity) : m_slots(nullptr), m_mask(0), m_head(0), m_subscribers(0) {
+        uint64_t size = 1;
+        while (size < static_cast<uint64_t>(capacity)) {
+            size *= 2;
+        }
+        m_slots = new Slot[size];
+        m_mask = size - 1;
+        for (uint64_t i = 0; i < size; ++i) {
+            m_slots[i].m_stamp.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    ~ChangeFeed() {
+        delete[] m_slots;
+    }
+
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    bool has_subscribers() const {
+        return m_subscribers.load(std::memory_order_relaxed) > 0;
+    }
+
+    // Producer only
+    void publish(int type, int team, int other = 0, int value = 0) {
+        if (!has_subscribers()) {
+            return;
+        }
+        uint64_t sequence = m_head.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[sequence & m_mask];
+        slot.m_stamp.store(2 * sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.m_words[0].store(pack(type, team), std::memory_order_relaxed);
+        slot.m_words[1].store(pack(other, value), std::memory_order_relaxed);
+        slot.m_stamp.store(2 * sequence + 2, std::memory_order_release);
+        m_head.store(sequence + 1, std::memory_order_release);
+    }
+
+    // A reader with its own position in the feed. It starts at the current
+    // end, so it sees only events published after it was created.
+    class Subscriber {
+    private:
+        ChangeFeed& m_feed;
+        uint64_t m_next;
+        uint64_t m_missed;
+
+    public:
+        explicit Subscriber(ChangeFeed& feed) : m_feed(feed), m_next(0), m_missed(0) {
+            m_feed.m_subscribers.fetch_add(1, std::memory_order_relaxed);
+            m_next = m_feed.m_head.load(std::memory_order_acquire);
+        }
+
+        ~Subscriber() {
+            m_feed.m_subscribers.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        Subscriber(const Subscriber&) = delete;
+        Subscriber& operator=(const Subscriber&) = delete;
+
+        // Copies up to max pending events into events; returns how many
+        int poll(ChangeEvent* events, int max) {
+            int count = 0;
+            while (count < max) {
+                uint64_t head = m_feed.m_head.load(std::memory_order_acquire);
+                if (m_next == head) {
+                    break;
+                }
+                if (head - m_next > m_feed.m_mask + 1) {
+                    // Overwritten before we got to them
+                    m_missed += head - (m_feed.m_mask + 1) - m_next;
+                    m_next = head - (m_feed.m_mask + 1);
+                }
+                Slot& slot = m_feed.m_slots[m_next & m_feed.m_mask];
+                uint64_t stamp = slot.m_stamp.load(std::memory_order_acquire);
+                uint64_t first = slot.m_words[0].load(std::memory_order_relaxed);
+                uint64_t second = slot.m_words[1].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (stamp != 2 * m_next + 2 || slot.m_stamp.load(std::memory_order_relaxed) != stamp) {
+                    // Being overwritten right now: re-read the head and skip ahead
+                    continue;
+                }
+                ChangeEvent& event = events[count++];
+                event.m_type = static_cast<int>(first >> 32);
+                event.m_team = static_cast<int>(static_cast<uint32_t>(first));
+                event.m_other = static_cast<int>(second >> 32);
+                event.m_value = static_cast<int>(static_cast<uint32_t>(second));
+                m_next++;
+            }
+            return count;
+        }
+
+        // Events lost because this subscriber fell behind by more than the capacity
+        uint64_t get_missed() const {
+            return m_missed;
+        }
+    };
+};
+
+// Coalesces a batch of events by team, in place, and returns the new count.
+// Consecutive record changes of one team become a single RECORD_CHANGED;
+// changes that a later merge makes irrelevant (the merge carries the new
+// absolute record) are dropped. Merges and retirements keep their order.
+// Throws std::bad_alloc if the scratch table cannot be allocated.
+inline int coalesce_events(ChangeEvent* events, int count) {
+    if (count <= 1) {
+        return count;
+    }
+    int capacity = 16;
+    while (capacity < 2 * count) {
+        capacity *= 2;
+    }
+    // Open-addressed team -> index of its pending RECORD_CHANGED event
+    int* teams = new int[capacity];
+    int* pending = new (std::nothrow) int[capacity];
+    if (!pending) {
+        delete[] teams;
+        throw std::bad_alloc();
+    }
+    for (int i = 0; i < capacity; ++i) {
+        pending[i] = -1;
+    }
+    const int mask = capacity - 1;
+    auto slot_of = [&](int team) {
+        int slot = static_cast<int>((static_cast<uint32_t>(team) * 0x9E3779B9u) >> 8) & mask;
+        while (pending[slot] != -1 && teams[slot] != team) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    };
+    const int DROPPED = 0;      // Event types are never 0
+
+    for (int i = 0; i < count; ++i) {
+        ChangeEvent& event = events[i];
+        if (event.m_type == ChangeEvent::RECORD_CHANGED) {
+            int slot = slot_of(event.m_team);
+            if (pending[slot] >= 0) {
+                events[pending[slot]].m_value += event.m_value;
+                event.m_type = DROPPED;
+            } else {
+                teams[slot] = event.m_team;
+                pending[slot] = i;
+            }
+        } else if (event.m_type == ChangeEvent::TEAMS_MERGED) {
+            // Both sides' pending deltas are folded into the merge's record.
+            // Their slots stay claimed (index -2) so probing is unaffected.
+            int ids[2] = {event.m_team, event.m_other};
+            for (int side = 0; side < 2; ++side) {
+                int slot = slot_of(ids[side]);
+                if (pending[slot] >= 0) {
+                    events[pending[slot]].m_type = DROPPED;
+                    pending[slot] = -2;
+                }
+            }
+        }
+    }
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+        if (events[i].m_type != DROPPED) {
+            events[kept++] = events[i];
+        }
+    }
+    delete[] pending;
+    delete[] teams;
+    return kept;
+}
+
+#endif // CHANGE_FEED_H
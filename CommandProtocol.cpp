@@ -0,0 +1,97 @@
+#include "CommandProtocol.h"
+
+static void write_word(unsigned char* bytes, int32_t value) {
+    uint32_t word = static_cast<uint32_t>(value);
+    bytes[0] = static_cast<unsigned char>(word);
+    bytes[1] = static_cast<unsigned char>(word >> 8);
+    bytes[2] = static_cast<unsigned char>(word >> 16);
+    bytes[3] = static_cast<unsigned char>(word >> 24);
+}
+
+static int32_t read_word(const unsigned char* bytes) {
+    uint32_t word = static_cast<uint32_t>(bytes[0])
+                  | (static_cast<uint32_t>(bytes[1]) << 8)
+                  | (static_cast<uint32_t>(bytes[2]) << 16)
+                  | (static_cast<uint32_t>(bytes[3]) << 24);
+    return static_cast<int32_t>(word);
+}
+
+static CommandResult make_result(StatusType status, int32_t answer = 0) {
+    CommandResult result;
+    result.m_status = static_cast<int32_t>(status);
+    result.m_answer = status == StatusType::SUCCESS ? answer : 0;
+    return result;
+}
+
+static CommandResult make_result(output_t<int> output) {
+    return make_result(output.status(), output.ans());
+}
+
+CommandResult execute_command(Plains& plains, const Command& command) {
+    const int32_t* args = command.m_args;
+    switch (static_cast<Opcode>(command.m_opcode)) {
+        case Opcode::ADD_TEAM:
+            return make_result(plains.add_team(args[0]));
+        case Opcode::ADD_JOCKEY:
+            return make_result(plains.add_jockey(args[0], args[1]));
+        case Opcode::UPDATE_MATCH:
+            return make_result(plains.update_match(args[0], args[1]));
+        case Opcode::MERGE_TEAMS:
+            return make_result(plains.merge_teams(args[0], args[1]));
+        case Opcode::UNITE_BY_RECORD:
+            return make_result(plains.unite_by_record(args[0]));
+        case Opcode::GET_JOCKEY_RECORD:
+            return make_result(plains.get_jockey_record(args[0]));
+        case Opcode::GET_TEAM_RECORD:
+            return make_result(plains.get_team_record(args[0]));
+    }
+    return make_result(StatusType::INVALID_INPUT);
+}
+
+void execute_commands(Plains& plains, const Command* commands, int count, CommandResult* results) {
+    for (int i = 0; i < count; ++i) {
+        results[i] = execute_command(plains, commands[i]);
+    }
+}
+
+std::size_t execute_stream(Plains& plains, const unsigned char* input, std::size_t inputBytes,
+                           unsigned char* output, std::size_t outputBytes, std::size_t* consumed) {
+    std::size_t count = inputBytes / COMMAND_BYTES;
+    if (outputBytes / RESULT_BYTES < count) {
+        count = outputBytes / RESULT_BYTES;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        Command command = decode_command(input + i * COMMAND_BYTES);
+        encode_result(execute_command(plains, command), output + i * RESULT_BYTES);
+    }
+    if (consumed) {
+        *consumed = count * COMMAND_BYTES;
+    }
+    return count;
+}
+
+void encode_command(const Command& command, unsigned char* bytes) {
+    write_word(bytes, command.m_opcode);
+    write_word(bytes + 4, command.m_args[0]);
+    write_word(bytes + 8, command.m_args[1]);
+}
+
+Command decode_command(const unsigned char* bytes) {
+    Command command;
+    command.m_opcode = read_word(bytes);
+    command.m_args[0] = read_word(bytes + 4);
+    command.m_args[1] = read_word(bytes + 8);
+    return command;
+}
+
+void encode_result(const CommandResult& result, unsigned char* bytes) {
+    write_word(bytes, result.m_status);
+    write_word(bytes + 4, result.m_answer);
+}
+
+CommandResult decode_result(const unsigned char* bytes) {
+    CommandResult result;
+    result.m_status = read_word(bytes);
+    result.m_answer = read_word(bytes + 4);
+    return result;
+}
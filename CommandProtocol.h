@@ -0,0 +1,63 @@
+#ifndef COMMAND_PROTOCOL_H
+#define COMMAND_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "plains25a2.h"
+
+// Binary command protocol for driving Plains without text I/O.
+//
+// A command is three little-endian int32 words: the opcode and two
+// arguments (unused arguments are 0). Every command produces exactly one
+// result of two int32 words: the StatusType value and the answer, which is
+// the record for GET_JOCKEY_RECORD / GET_TEAM_RECORD and 0 otherwise.
+// Results come out in command order, so a result stream lines up with its
+// command stream by position.
+
+enum struct Opcode : int32_t {
+    ADD_TEAM          = 1,  // teamId
+    ADD_JOCKEY        = 2,  // jockeyId, teamId
+    UPDATE_MATCH      = 3,  // victoriousJockeyId, losingJockeyId
+    MERGE_TEAMS       = 4,  // teamId1, teamId2
+    UNITE_BY_RECORD   = 5,  // record
+    GET_JOCKEY_RECORD = 6,  // jockeyId
+    GET_TEAM_RECORD   = 7,  // teamId
+};
+
+struct Command {
+    int32_t m_opcode;       // An Opcode value; anything else yields INVALID_INPUT
+    int32_t m_args[2];
+};
+
+struct CommandResult {
+    int32_t m_status;       // A StatusType value
+    int32_t m_answer;
+};
+
+static constexpr std::size_t COMMAND_BYTES = 3 * sizeof(int32_t);
+static constexpr std::size_t RESULT_BYTES = 2 * sizeof(int32_t);
+
+static_assert(sizeof(Command) == COMMAND_BYTES, "Command must have no padding");
+static_assert(sizeof(CommandResult) == RESULT_BYTES, "CommandResult must have no padding");
+
+// Runs a single command
+CommandResult execute_command(Plains& plains, const Command& command);
+
+// Runs count commands in order and writes one result per command
+void execute_commands(Plains& plains, const Command* commands, int count, CommandResult* results);
+
+// Streaming executor over raw wire buffers. Executes as many whole commands
+// from input as there is room for results in output, and returns the number
+// of commands executed. *consumed is set to the input bytes used; a trailing
+// partial command is left for the next call, together with the bytes after it.
+std::size_t execute_stream(Plains& plains, const unsigned char* input, std::size_t inputBytes,
+                           unsigned char* output, std::size_t outputBytes, std::size_t* consumed);
+
+// Wire encoding of a single command / result (little-endian, unaligned)
+void encode_command(const Command& command, unsigned char* bytes);
+Command decode_command(const unsigned char* bytes);
+void encode_result(const CommandResult& result, unsigned char* bytes);
+CommandResult decode_result(const unsigned char* bytes);
+
+#endif // COMMAND_PROTOCOL_H
@@ -0,0 +1,235 @@
+#include "CompactPlains.h"
+
+CompactPlains::CompactPlains() : m_jockeys(), m_teams(), m_forest(), m_node_count(0), m_record_index() {
+}
+
+CompactPlains::~CompactPlains() {
+}
+
+int CompactPlains::find_live_team(int teamId)
+{
+    const TeamSlot* team = m_teams.find(teamId);
+    if (!team) {
+        return -1;
+    }
+    // After a merge the absorbed ID still maps to its node, but that node is
+    // either no longer a root or the root carries the survivor's ID
+    int node = team->m_node;
+    if (!m_forest.is_root(node) || m_forest.storage().payload(node).m_id != teamId) {
+        return -1;
+    }
+    return node;
+}
+
+int CompactPlains::team_root(JockeySlot* jockey)
+{
+    int root = m_forest.find(jockey->m_team);
+    jockey->m_team = root;
+    return root;
+}
+
+void CompactPlains::reserve_nodes(int count)
+{
+    int capacity = m_forest.storage().get_capacity();
+    if (count <= capacity) {
+        return;
+    }
+    long long grown = 2LL * capacity;
+    grown = grown < count ? count : grown;
+    grown = grown < 64 ? 64 : grown;
+    m_forest.storage().reserve(grown > INT32_MAX ? INT32_MAX : static_cast<int>(grown));
+}
+
+// Same contract as Plains::add_team.
+// Time complexity: O(1) on average over the expected input.
+StatusType CompactPlains::add_team(int teamId)
+{
+    try{
+        if (teamId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        if (m_teams.find(teamId)) {
+            return StatusType::FAILURE;
+        }
+        // Everything that can fail comes first
+        reserve_nodes(m_node_count + 1);
+        m_record_index.reserve_slots(1);
+        TeamSlot* team = m_teams.insert(teamId);
+
+        int node = m_node_count++;
+        team->m_node = node;
+        m_forest.make_set(node);
+        m_forest.storage().payload(node).m_id = teamId;
+        m_forest.storage().payload(node).m_record = 0;
+        m_record_index.add(0, teamId);
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Same contract as Plains::add_jockey.
+// Time complexity: O(1) on average over the expected input.
+StatusType CompactPlains::add_jockey(int jockeyId, int teamId)
+{
+    try{
+        if (jockeyId <= 0 || teamId <= 0) {
+            return StatusType::INVALID_INPUT;
+        }
+        int team = find_live_team(teamId);
+        if (team < 0 || m_jockeys.find(jockeyId)) {
+            return StatusType::FAILURE;
+        }
+        JockeySlot* jockey = m_jockeys.insert(jockeyId);
+        jockey->m_team = team;
+        jockey->m_record = 0;
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Same contract as Plains::update_match.
+// Time complexity: O(log* m) on average over the input evaluated together with merge_teams and unite_by_record.
+StatusType CompactPlains::update_match(int victoriousJockeyId, int losingJockeyId)
+{
+    try{
+        if (victoriousJockeyId <= 0 || losingJockeyId <= 0 || victoriousJockeyId == losingJockeyId) {
+            return StatusType::INVALID_INPUT;
+        }
+        JockeySlot* winner = m_jockeys.find(victoriousJockeyId);
+        JockeySlot* loser = m_jockeys.find(losingJockeyId);
+        if (!winner || !loser) {
+            return StatusType::FAILURE;
+        }
+        int winningTeam = team_root(winner);
+        int losingTeam = team_root(loser);
+        if (winningTeam == losingTeam) {
+            return StatusType::FAILURE;
+        }
+        m_record_index.reserve_slots(2);
+        winner->m_record++;
+        loser->m_record--;
+        TeamPayload& winnerPayload = m_forest.storage().payload(winningTeam);
+        TeamPayload& loserPayload = m_forest.storage().payload(losingTeam);
+        winnerPayload.m_record++;
+        loserPayload.m_record--;
+        m_record_index.move(winnerPayload.m_record - 1, winnerPayload.m_record, winnerPayload.m_id);
+        m_record_index.move(loserPayload.m_record + 1, loserPayload.m_record, loserPayload.m_id);
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Same contract as Plains::merge_teams.
+// Time complexity: O(log* m) on average over the input considered together with unite_by_record and update_match.
+StatusType CompactPlains::merge_teams(int teamId1, int teamId2)
+{
+    try{
+        if (teamId1 <= 0 || teamId2 <= 0 || teamId1 == teamId2) {
+            return StatusType::INVALID_INPUT;
+        }
+        int node1 = find_live_team(teamId1);
+        int node2 = find_live_team(teamId2);
+        if (node1 < 0 || node2 < 0) {
+            return StatusType::FAILURE;
+        }
+        m_record_index.reserve_slots(1);
+
+        // The team with the better record keeps its ID (teamId1 on a tie)
+        TeamPayload first = m_forest.storage().payload(node1);
+        TeamPayload second = m_forest.storage().payload(node2);
+        const TeamPayload& survivor = second.m_record > first.m_record ? second : first;
+        const TeamPayload& absorbed = second.m_record > first.m_record ? first : second;
+
+        // The linking policy picks the root node; it takes the survivor's ID,
+        // and the survivor's map entry follows it
+        int root = m_forest.pick_root(node1, node2);
+        int child = root == node1 ? node2 : node1;
+        m_teams.find(survivor.m_id)->m_node = root;
+        m_forest.storage().payload(root).m_id = survivor.m_id;
+        m_forest.link(root, child);
+
+        m_record_index.remove(absorbed.m_record, absorbed.m_id);
+        m_record_index.move(survivor.m_record, survivor.m_record + absorbed.m_record, survivor.m_id);
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Same contract as Plains::unite_by_record.
+// Time complexity: O(log* m) on average over input evaluated together with update_match and merge_teams.
+StatusType CompactPlains::unite_by_record(int record)
+{
+    if (record <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    int teamId1 = m_record_index.unique_id(record);
+    int teamId2 = m_record_index.unique_id(-record);
+    if (teamId1 == 0 || teamId2 == 0) {
+        return StatusType::FAILURE;
+    }
+    return merge_teams(teamId1, teamId2);
+}
+
+// Same contract as Plains::get_jockey_record.
+// Time complexity: O(1) on average over the input.
+output_t<int> CompactPlains::get_jockey_record(int jockeyId)
+{
+    if (jockeyId <= 0) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    const JockeySlot* jockey = m_jockeys.find(jockeyId);
+    if (!jockey) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(jockey->m_record);
+}
+
+// Same contract as Plains::get_team_record.
+// Time complexity: O(1) on average over the input.
+output_t<int> CompactPlains::get_team_record(int teamId)
+{
+    if (teamId <= 0) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    int node = find_live_team(teamId);
+    if (node < 0) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(m_forest.storage().payload(node).m_record);
+}
+
+// Sizes the rider table, the team table and the team nodes for the given
+// totals (past teams included), so that loading them never grows a table.
+
+// Return value:
+// • ALLOCATION_ERROR in case of a memory allocation problem.
+// • INVALID_INPUT if numTeams < 0 or numJockeys < 0.
+// • SUCCESS on success.
+// Time complexity: O(n + m + numTeams + numJockeys) in the worst case.
+StatusType CompactPlains::reserve(int numTeams, int numJockeys)
+{
+    if (numTeams < 0 || numJockeys < 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        m_jockeys.reserve(numJockeys);
+        m_teams.reserve(numTeams);
+        if (numTeams > m_forest.storage().get_capacity()) {
+            m_forest.storage().reserve(numTeams);
+        }
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+long long CompactPlains::memory_bytes() const
+{
+    long long nodeBytes = 2 * sizeof(int) + sizeof(TeamPayload);
+    return m_jockeys.memory_bytes() + m_teams.memory_bytes() +
+           nodeBytes * m_forest.storage().get_capacity();
+}
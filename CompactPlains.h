@@ -0,0 +1,98 @@
+#ifndef COMPACT_PLAINS_H
+#define COMPACT_PLAINS_H
+
+#include "wet2util.h"
+#include "Dsu.h"
+#include "FlatTable.h"
+#include "RecordIndex.h"
+
+// Memory-compact engine with the seven Plains operations and identical
+// results, for leagues with hundreds of millions of riders.
+//
+// Plains gives every rider a GenericNode (shared_ptr, parent pointer, size and
+// offset: 32 bytes) plus a Participant with a vtable and a shared_ptr control
+// block, plus a chained map entry. Here a rider is one 12-byte record stored
+// inline in an open-addressed table keyed by its ID: the ID, a 32-bit handle
+// of its team node and its record. Riders are always leaves of the forest,
+// so nothing ever points at them and the table is free to move them when it
+// grows. At the table's 7/8 maximum load that is 13.7 to 20.6 bytes per rider;
+// reserve() sizes it up front for the low end.
+//
+// Team nodes live in a Dsu over ArrayStorage (32-bit parent and size arrays
+// plus an 8-byte payload), addressed by the handle the team got when it was
+// added. The extensions of Plains (bulk loads, team-relative queries,
+// compaction, threads, the change feed) are not available here.
+class CompactPlains {
+private:
+    struct JockeySlot {
+        int m_id;
+        int m_team;         // Handle of a team node; the root after a find
+        int m_record;
+    };
+
+    struct TeamSlot {
+        int m_id;
+        int m_node;         // Handle of the node the team was added with
+    };
+
+    // Roots carry the current ID and record of their merged team
+    struct TeamPayload {
+        int m_id;
+        int m_record;
+    };
+
+    // Linking a root under another adds its record to the surviving team
+    struct TeamRecordAggregate {
+        template<typename S>
+        void combine(S& s, int root, int child) {
+            s.payload(root).m_record += s.payload(child).m_record;
+        }
+
+        template<typename S>
+        void split(S& s, int root, int child) {
+            s.payload(root).m_record -= s.payload(child).m_record;
+        }
+    };
+
+    FlatTable<JockeySlot> m_jockeys;
+    FlatTable<TeamSlot> m_teams;
+    Dsu<ArrayStorage<TeamPayload>, LinkBySize, FullCompression, TeamRecordAggregate> m_forest;
+    int m_node_count;
+
+    // Live (root) teams by record, used by unite_by_record
+    RecordIndex m_record_index;
+
+    static_assert(sizeof(JockeySlot) == 12, "JockeySlot must stay packed");
+
+    // The root node of the live team teamId, or -1
+    int find_live_team(int teamId);
+
+    // Root of the rider's team; the rider is repointed at it
+    int team_root(JockeySlot* jockey);
+
+    // Makes room for count team nodes
+    void reserve_nodes(int count);
+
+public:
+    CompactPlains();
+    ~CompactPlains();
+
+    CompactPlains(const CompactPlains&) = delete;
+    CompactPlains& operator=(const CompactPlains&) = delete;
+
+    StatusType add_team(int teamId);
+    StatusType add_jockey(int jockeyId, int teamId);
+    StatusType update_match(int victoriousJockeyId, int losingJockeyId);
+    StatusType merge_teams(int teamId1, int teamId2);
+    StatusType unite_by_record(int record);
+    output_t<int> get_jockey_record(int jockeyId);
+    output_t<int> get_team_record(int teamId);
+
+    // Sizes the tables for numTeams teams and numJockeys riders in total
+    StatusType reserve(int numTeams, int numJockeys);
+
+    // Bytes held by the rider table, the team table and the team nodes
+    long long memory_bytes() const;
+};
+
+#endif // COMPACT_PLAINS_H
@@ -0,0 +1,452 @@
+#ifndef DSU_H
+#define DSU_H
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Disjoint-set forest assembled from four policies:
+//   Storage      where parents, weights and payloads live (PointerStorage, ArrayStorage)
+//   Linking      which root survives a union (LinkBySize, LinkByRank, LinkRandomized)
+//   Compression  what find does to the path (FullCompression, PathHalving,
+//                PathSplitting, NoCompression)
+//   Aggregate    per-root payload combined on union (NoAggregate, SumAggregate)
+// Elements are addressed by Storage::Handle. With NoCompression every union
+// can be undone with checkpoint() / rollback().
+//
+// Storages with edge offsets (WeightedPointerStorage) make the forest a
+// weighted union-find: add_to_set adds a delta to every current member of a
+// set in O(1), and value(h) sums the deltas h received while it was a member
+// of its sets. Links and every compression policy keep the path sums intact;
+// for the other storages the offset hooks are empty and compile away.
+//
+// relink_step shortens one path by a single hop without a find, so callers
+// can spread compression over time in fixed-size slices.
+
+// ---------------------------------------------------------------- Storage
+
+// Intrusive storage: handles are node pointers, and the node type provides
+// m_parent (Node*) and m_size (int, the linking weight). The nodes are owned
+// elsewhere; the storage itself is stateless.
+template<typename Node>
+struct PointerStorage {
+    typedef Node* Handle;
+
+    Handle parent(Handle h) const { return h->m_parent; }
+    void set_parent(Handle h, Handle parent) { h->m_parent = parent; }
+    int weight(Handle h) const { return h->m_size; }
+    void set_weight(Handle h, int weight) { h->m_size = weight; }
+    int offset(Handle) const { return 0; }
+    void set_offset(Handle, int) {}
+};
+
+// PointerStorage with an offset on every parent edge (node field m_offset,
+// int). A root's offset applies to its whole set.
+template<typename Node>
+struct WeightedPointerStorage : PointerStorage<Node> {
+    typedef Node* Handle;
+
+    int offset(Handle h) const { return h->m_offset; }
+    void set_offset(Handle h, int offset) { h->m_offset = offset; }
+};
+
+// Dense storage: handles are indices 0..capacity-1 into parallel arrays, with
+// one Payload per element for SumAggregate
+template<typename Payload = int>
+class ArrayStorage {
+private:
+    int* m_parents;
+    int* m_weights;
+    Payload* m_payloads;
+    int m_capacity;
+
+public:
+    typedef int Handle;
+
+    ArrayStorage() : m_parents(nullptr), m_weights(nullptr), m_payloads(nullptr), m_capacity(0) {}
+
+    ~ArrayStorage() {
+        delete[] m_parents;
+        delete[] m_weights;
+        delete[] m_payloads;
+    }
+
+    ArrayStorage(const ArrayStorage&) = delete;
+    ArrayStorage& operator=(const ArrayStorage&) = delete;
+
+    // Makes room for handles below capacity. Existing elements keep their
+    // state; new ones are undefined until make_set.
+    void reserve(int capacity) {
+        if (capacity <= m_capacity) {
+            return;
+        }
+        int* parents = new int[capacity];
+        int* weights = new (std::nothrow) int[capacity];
+        Payload* payloads = weights ? new (std::nothrow) Payload[capacity] : nullptr;
+        if (!payloads) {
+            delete[] weights;
+            delete[] parents;
+            throw std::bad_alloc();
+        }
+        for (int i = 0; i < m_capacity; ++i) {
+            parents[i] = m_parents[i];
+            weights[i] = m_weights[i];
+            payloads[i] = m_payloads[i];
+        }
+        delete[] m_parents;
+        delete[] m_weights;
+        delete[] m_payloads;
+        m_parents = parents;
+        m_weights = weights;
+        m_payloads = payloads;
+        m_capacity = capacity;
+    }
+
+    int get_capacity() const { return m_capacity; }
+
+    Handle parent(Handle h) const { return m_parents[h]; }
+    void set_parent(Handle h, Handle parent) { m_parents[h] = parent; }
+    int weight(Handle h) const { return m_weights[h]; }
+    void set_weight(Handle h, int weight) { m_weights[h] = weight; }
+    int offset(Handle) const { return 0; }
+    void set_offset(Handle, int) {}
+    Payload& payload(Handle h) { return m_payloads[h]; }
+    const Payload& payload(Handle h) const { return m_payloads[h]; }
+};
+
+// ---------------------------------------------------------------- Linking
+
+// Union by size: the weight is the number of elements in the set
+struct LinkBySize {
+    static constexpr bool TRACKS_SIZE = true;
+
+    template<typename S>
+    void make_set(S& s, typename S::Handle h) { s.set_weight(h, 1); }
+
+    template<typename S>
+    typename S::Handle pick_root(S& s, typename S::Handle a, typename S::Handle b) {
+        return s.weight(a) < s.weight(b) ? b : a;
+    }
+
+    template<typename S>
+    void link(S& s, typename S::Handle root, typename S::Handle child) {
+        s.set_weight(root, s.weight(root) + s.weight(child));
+    }
+};
+
+// Union by rank: the weight is an upper bound on the height of the tree
+struct LinkByRank {
+    static constexpr bool TRACKS_SIZE = false;
+
+    template<typename S>
+    void make_set(S& s, typename S::Handle h) { s.set_weight(h, 0); }
+
+    template<typename S>
+    typename S::Handle pick_root(S& s, typename S::Handle a, typename S::Handle b) {
+        return s.weight(a) < s.weight(b) ? b : a;
+    }
+
+    template<typename S>
+    void link(S& s, typename S::Handle root, typename S::Handle child) {
+        if (s.weight(root) == s.weight(child)) {
+            s.set_weight(root, s.weight(root) + 1);
+        }
+    }
+};
+
+// Randomized linking: a coin flip per union, no weight maintenance.
+// Expected O(log n) depth without storing anything per element.
+class LinkRandomized {
+private:
+    uint64_t m_state;
+
+public:
+    static constexpr bool TRACKS_SIZE = false;
+
+    LinkRandomized() : m_state(0x9E3779B97F4A7C15ull) {}
+
+    template<typename S>
+    void make_set(S& s, typename S::Handle h) { s.set_weight(h, 0); }
+
+    template<typename S>
+    typename S::Handle pick_root(S&, typename S::Handle a, typename S::Handle b) {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return (m_state >> 32) & 1 ? a : b;
+    }
+
+    template<typename S>
+    void link(S&, typename S::Handle, typename S::Handle) {}
+};
+
+// ---------------------------------------------------------------- Compression
+
+// Two passes: find the root, then point every node on the path at it
+struct FullCompression {
+    static constexpr bool ROLLBACK = false;
+
+    template<typename S>
+    static typename S::Handle find(S& s, typename S::Handle h) {
+        typename S::Handle root = h;
+        int below = 0;      // Offsets from h up to, not including, the root
+        while (s.parent(root) != root) {
+            below += s.offset(root);
+            root = s.parent(root);
+        }
+        while (h != root) {
+            typename S::Handle next = s.parent(h);
+            int own = s.offset(h);
+            s.set_offset(h, below);
+            s.set_parent(h, root);
+            below -= own;
+            h = next;
+        }
+        return root;
+    }
+};
+
+// One pass: every other node on the path skips to its grandparent
+struct PathHalving {
+    static constexpr bool ROLLBACK = false;
+
+    template<typename S>
+    static typename S::Handle find(S& s, typename S::Handle h) {
+        while (s.parent(h) != h) {
+            typename S::Handle parent = s.parent(h);
+            typename S::Handle grandparent = s.parent(parent);
+            if (grandparent != parent) {
+                s.set_offset(h, s.offset(h) + s.offset(parent));
+                s.set_parent(h, grandparent);
+            }
+            h = grandparent;
+        }
+        return h;
+    }
+};
+
+// One pass: every node on the path skips to its grandparent
+struct PathSplitting {
+    static constexpr bool ROLLBACK = false;
+
+    template<typename S>
+    static typename S::Handle find(S& s, typename S::Handle h) {
+        while (s.parent(h) != h) {
+            typename S::Handle parent = s.parent(h);
+            typename S::Handle grandparent = s.parent(parent);
+            if (grandparent != parent) {
+                s.set_offset(h, s.offset(h) + s.offset(parent));
+                s.set_parent(h, grandparent);
+            }
+            h = parent;
+        }
+        return h;
+    }
+};
+
+// Read-only finds. Unions are then the only writes, so they can be undone.
+struct NoCompression {
+    static constexpr bool ROLLBACK = true;
+
+    template<typename S>
+    static typename S::Handle find(S& s, typename S::Handle h) {
+        while (s.parent(h) != h) {
+            h = s.parent(h);
+        }
+        return h;
+    }
+};
+
+// ---------------------------------------------------------------- Aggregate
+
+struct NoAggregate {
+    template<typename S>
+    void combine(S&, typename S::Handle, typename S::Handle) {}
+
+    template<typename S>
+    void split(S&, typename S::Handle, typename S::Handle) {}
+};
+
+// The root's payload is the sum over its set (storage must provide payload)
+struct SumAggregate {
+    template<typename S>
+    void combine(S& s, typename S::Handle root, typename S::Handle child) {
+        s.payload(root) += s.payload(child);
+    }
+
+    template<typename S>
+    void split(S& s, typename S::Handle root, typename S::Handle child) {
+        s.payload(root) -= s.payload(child);
+    }
+};
+
+// ---------------------------------------------------------------- Forest
+
+template<typename Storage, typename Linking = LinkBySize, typename Compression = FullCompression,
+         typename Aggregate = NoAggregate>
+class Dsu {
+public:
+    typedef typename Storage::Handle Handle;
+
+private:
+    // One undo record per link while rollback is possible
+    struct LinkRecord {
+        Handle m_root;
+        Handle m_child;
+        int m_root_weight;
+        int m_child_offset;
+    };
+
+    Storage m_storage;
+    Linking m_linking;
+    Aggregate m_aggregate;
+    LinkRecord* m_history;
+    int m_history_size;
+    int m_history_capacity;
+
+    void reserve_history() {
+        if (m_history_size < m_history_capacity) {
+            return;
+        }
+        int capacity = m_history_capacity ? 2 * m_history_capacity : 64;
+        LinkRecord* history = new LinkRecord[capacity];
+        for (int i = 0; i < m_history_size; ++i) {
+            history[i] = m_history[i];
+        }
+        delete[] m_history;
+        m_history = history;
+        m_history_capacity = capacity;
+    }
+
+public:
+    Dsu() : m_storage(), m_linking(), m_aggregate(), m_history(nullptr), m_history_size(0),
+            m_history_capacity(0) {}
+
+    ~Dsu() {
+        delete[] m_history;
+    }
+
+    Dsu(const Dsu&) = delete;
+    Dsu& operator=(const Dsu&) = delete;
+
+    Storage& storage() { return m_storage; }
+    const Storage& storage() const { return m_storage; }
+
+    // Makes h a singleton set
+    void make_set(Handle h) {
+        m_storage.set_parent(h, h);
+        m_storage.set_offset(h, 0);
+        m_linking.make_set(m_storage, h);
+    }
+
+    Handle find(Handle h) {
+        return Compression::find(m_storage, h);
+    }
+
+    bool is_root(Handle h) const {
+        return m_storage.parent(h) == h;
+    }
+
+    bool same_set(Handle a, Handle b) {
+        return find(a) == find(b);
+    }
+
+    // The root that link would keep for two distinct roots. Callers that
+    // must know the survivor before the union call this, then link.
+    Handle pick_root(Handle a, Handle b) {
+        return m_linking.pick_root(m_storage, a, b);
+    }
+
+    // Hangs the root child under the root root, combining weights and payloads.
+    // With NoCompression every link is also logged for rollback; that log
+    // may throw std::bad_alloc, and then before anything changed.
+    void link(Handle root, Handle child) {
+        if (Compression::ROLLBACK) {
+            reserve_history();
+            LinkRecord& record = m_history[m_history_size++];
+            record.m_root = root;
+            record.m_child = child;
+            record.m_root_weight = m_storage.weight(root);
+            record.m_child_offset = m_storage.offset(child);
+        }
+        m_linking.link(m_storage, root, child);
+        m_aggregate.combine(m_storage, root, child);
+        // The child's subtree keeps its values under the root's offset
+        m_storage.set_offset(child, m_storage.offset(child) - m_storage.offset(root));
+        m_storage.set_parent(child, root);
+    }
+
+    // Unites the sets of a and b; returns the root of the union
+    Handle unite(Handle a, Handle b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) {
+            return a;
+        }
+        Handle root = pick_root(a, b);
+        link(root, root == a ? b : a);
+        return root;
+    }
+
+    // Adds the singleton h to the set rooted at root
+    void attach(Handle h, Handle root) {
+        make_set(h);
+        link(root, h);
+    }
+
+    // One step of incremental compression, independent of any find: h skips
+    // to its grandparent. Returns true once h is a root or a root's child.
+    bool relink_step(Handle h) {
+        static_assert(!Compression::ROLLBACK, "relinking would break rollback");
+        Handle parent = m_storage.parent(h);
+        Handle grandparent = m_storage.parent(parent);
+        if (grandparent == parent) {
+            return true;
+        }
+        m_storage.set_offset(h, m_storage.offset(h) + m_storage.offset(parent));
+        m_storage.set_parent(h, grandparent);
+        return m_storage.parent(grandparent) == grandparent;
+    }
+
+    // Adds delta to the value of every current member of root's set
+    void add_to_set(Handle root, int delta) {
+        m_storage.set_offset(root, m_storage.offset(root) + delta);
+    }
+
+    // Sum of the deltas added to h's sets while h was a member
+    int value(Handle h) {
+        Handle root = find(h);
+        int sum = m_storage.offset(root);
+        while (h != root) {
+            sum += m_storage.offset(h);
+            h = m_storage.parent(h);
+        }
+        return sum;
+    }
+
+    // Number of elements in h's set
+    int set_size(Handle h) {
+        static_assert(Linking::TRACKS_SIZE, "set_size needs LinkBySize");
+        return m_storage.weight(find(h));
+    }
+
+    // Number of links so far; pass it to rollback to undo the later ones
+    int checkpoint() const {
+        static_assert(Compression::ROLLBACK, "rollback needs NoCompression");
+        return m_history_size;
+    }
+
+    // Undoes every link made after the checkpoint, newest first
+    void rollback(int checkpoint) {
+        static_assert(Compression::ROLLBACK, "rollback needs NoCompression");
+        while (m_history_size > checkpoint) {
+            const LinkRecord& record = m_history[--m_history_size];
+            m_storage.set_parent(record.m_child, record.m_child);
+            m_storage.set_offset(record.m_child, record.m_child_offset);
+            m_aggregate.split(m_storage, record.m_root, record.m_child);
+            m_storage.set_weight(record.m_root, record.m_root_weight);
+        }
+    }
+};
+
+#endif // DSU_H
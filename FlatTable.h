@@ -0,0 +1,172 @@
+#ifndef FLAT_TABLE_H
+#define FLAT_TABLE_H
+
+#include <cstdint>
+#include <new>
+
+#include "HashPolicies.h"
+
+// Open-addressed table that stores its records inline, keyed by their int
+// field m_id (> 0; 0 marks an empty slot). Removing a record shifts the rest
+// of its probe run back, so linear probing needs no tombstones. The capacity
+// can be any size: the 32-bit Fibonacci hash is mapped onto it with a
+// multiply and a shift, so reserve() can size a table to exactly the
+// requested load instead of the next power of two.
+//
+// Growing and shrinking move every record, and a removal may move others of
+// its run, so pointers returned by find / insert are only valid until the
+// next insert, remove, reserve or shrink.
+template<typename Record>
+class FlatTable {
+private:
+    // At most 7/8 full; growth multiplies the capacity by 3/2
+    static constexpr int LOAD_NUM = 7;
+    static constexpr int LOAD_DEN = 8;
+    static constexpr int MIN_CAPACITY = 16;
+
+    Record* m_slots;
+    int m_capacity;
+    int m_size;
+
+    int home_slot(int id) const {
+        return static_cast<int>((static_cast<uint64_t>(FibonacciHash::hash(id)) *
+                                 static_cast<uint64_t>(m_capacity)) >> 32);
+    }
+
+    static bool fits(long long size, long long capacity) {
+        return size * LOAD_DEN <= capacity * LOAD_NUM;
+    }
+
+    void rehash(int capacity) {
+        Record* slots = new Record[capacity];
+        for (int i = 0; i < capacity; ++i) {
+            slots[i].m_id = 0;
+        }
+        Record* oldSlots = m_slots;
+        int oldCapacity = m_capacity;
+        m_slots = slots;
+        m_capacity = capacity;
+        for (int i = 0; i < oldCapacity; ++i) {
+            if (oldSlots[i].m_id != 0) {
+                m_slots[free_slot(oldSlots[i].m_id)] = oldSlots[i];
+            }
+        }
+        delete[] oldSlots;
+    }
+
+    // First empty slot on the probe sequence of id
+    int free_slot(int id) const {
+        int slot = home_slot(id);
+        while (m_slots[slot].m_id != 0) {
+            slot = slot + 1 < m_capacity ? slot + 1 : 0;
+        }
+        return slot;
+    }
+
+public:
+    FlatTable() : m_slots(nullptr), m_capacity(0), m_size(0) {}
+
+    ~FlatTable() {
+        delete[] m_slots;
+    }
+
+    FlatTable(const FlatTable&) = delete;
+    FlatTable& operator=(const FlatTable&) = delete;
+
+    // Makes room for count records in total without growing again
+    void reserve(int count) {
+        if (m_capacity > 0 && fits(count, m_capacity)) {
+            return;
+        }
+        long long needed = static_cast<long long>(count) * LOAD_DEN / LOAD_NUM + 1;
+        long long grown = static_cast<long long>(m_capacity) * 3 / 2;
+        long long capacity = needed > grown ? needed : grown;
+        capacity = capacity < MIN_CAPACITY ? MIN_CAPACITY : capacity;
+        if (capacity > INT32_MAX) {
+            throw std::bad_alloc();
+        }
+        rehash(static_cast<int>(capacity));
+    }
+
+    Record* find(int id) {
+        if (m_size == 0) {
+            return nullptr;
+        }
+        int slot = home_slot(id);
+        while (m_slots[slot].m_id != 0) {
+            if (m_slots[slot].m_id == id) {
+                return m_slots + slot;
+            }
+            slot = slot + 1 < m_capacity ? slot + 1 : 0;
+        }
+        return nullptr;
+    }
+
+    const Record* find(int id) const {
+        return const_cast<FlatTable*>(this)->find(id);
+    }
+
+    // Adds a record for an id that is not in the table yet. Only m_id is
+    // set; the caller fills in the rest. May throw std::bad_alloc, and then
+    // before anything changed.
+    Record* insert(int id) {
+        reserve(m_size + 1);
+        int slot = free_slot(id);
+        m_slots[slot].m_id = id;
+        m_size++;
+        return m_slots + slot;
+    }
+
+    // Removes a record returned by find / insert / slot. Records after it on
+    // the probe run that may live closer to their home slot move into the
+    // hole, so a sweep over the slots can miss one record per removal.
+    void remove(Record* record) {
+        int hole = static_cast<int>(record - m_slots);
+        int slot = hole;
+        while (true) {
+            slot = slot + 1 < m_capacity ? slot + 1 : 0;
+            if (m_slots[slot].m_id == 0) {
+                break;
+            }
+            // Keep records whose home lies cyclically in (hole, slot]
+            int home = home_slot(m_slots[slot].m_id);
+            bool stays = hole <= slot ? hole < home && home <= slot : hole < home || home <= slot;
+            if (!stays) {
+                m_slots[hole] = m_slots[slot];
+                hole = slot;
+            }
+        }
+        m_slots[hole].m_id = 0;
+        m_size--;
+    }
+
+    // Gives memory back once the table is less than a quarter as full as it
+    // may be, leaving it half full. May throw std::bad_alloc, and then
+    // before anything changed.
+    void shrink() {
+        if (m_capacity <= MIN_CAPACITY || !fits(4 * static_cast<long long>(m_size), m_capacity)) {
+            return;
+        }
+        long long capacity = static_cast<long long>(m_size) * 2 * LOAD_DEN / LOAD_NUM + 1;
+        rehash(capacity < MIN_CAPACITY ? MIN_CAPACITY : static_cast<int>(capacity));
+    }
+
+    // The record in slot index (below get_capacity()), or nullptr if the
+    // slot is empty, for sweeps over the whole table
+    Record* slot(int index) {
+        return m_slots[index].m_id != 0 ? m_slots + index : nullptr;
+    }
+
+    const Record* slot(int index) const {
+        return m_slots[index].m_id != 0 ? m_slots + index : nullptr;
+    }
+
+    int get_size() const { return m_size; }
+    int get_capacity() const { return m_capacity; }
+
+    long long memory_bytes() const {
+        return static_cast<long long>(m_capacity) * sizeof(Record);
+    }
+};
+
+#endif // FLAT_TABLE_H
@@ -8,7 +8,7 @@
 
 using namespace std;
 
-// Extracted GenericNode struct outside of UnionFind class
+// Team / jockey node of the Plains forest (WeightedPointerStorage in Dsu.h)
 template <typename Jockey, typename Team>
 class GenericNode {
 private:
@@ -20,9 +20,12 @@ public:
 
     std::shared_ptr<Participant> m_data;  // Pointer to the actual object (Jockey, Team)
     GenericNode* m_parent;                       // Raw pointer to the parent node
-    int m_size;                           // Score of the team
+    int m_size;                           // Linking weight (set size)
+    int m_offset;                         // Edge offset of the weighted forest
 
-    GenericNode(const std::shared_ptr<Participant>& m_data) : m_data(m_data), m_parent(this), m_size(0) {}
+    GenericNode() : m_data(), m_parent(this), m_size(0), m_offset(0) {}
+
+    GenericNode(const std::shared_ptr<Participant>& m_data) : m_data(m_data), m_parent(this), m_size(0), m_offset(0) {}
 
     bool operator==(const GenericNode& other) const {
         return m_data->m_id == other.m_data->m_id;
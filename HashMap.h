@@ -5,39 +5,82 @@
 #include <cmath>
 
 #include "List.h"
+#include "ThreadPool.h"
+#include "Instrumentation.h"
+#include "HashPolicies.h"
+#include "Numa.h"
 
 using namespace std;
 
-template<typename ValueType>
+template<typename ValueType, typename KeyType = int>
 struct HashNode {
-    int m_key;
+    KeyType m_key;
     ValueType* m_value; 
 
-    HashNode() : m_key(0), m_value(nullptr) {} 
+    HashNode() : m_key(), m_value(nullptr) {} 
 
-    bool operator==(const HashNode<ValueType>& other) const {
+    bool operator==(const HashNode<ValueType, KeyType>& other) const {
         return m_key == other.m_key && m_value == other.m_value;
     }
 };
 
 
-// HashMap class with integer keys and generic values
-template<typename ValueType>
+// HashMap class with integer keys and generic values.
+// The key type, the hash and growth policies (see HashPolicies.h) and the
+// maximal load factor LOAD_NUM / LOAD_DEN are compile-time parameters, so
+// e.g. FibonacciHash + PowerOfTwoGrowth indexes with a multiply, shift and
+// mask. The defaults keep the original prime-sized table.
+template<typename ValueType, typename KeyType = int, typename HashPolicy = IdentityHash,
+         typename GrowthPolicy = PrimeGrowth, int LOAD_NUM = 3, int LOAD_DEN = 4>
 class HashMap {
 private:
-    List<HashNode<ValueType>>* m_buckets; 
+    static_assert(LOAD_NUM > 0 && LOAD_DEN > 0, "load factor must be positive");
+
+    typedef HashNode<ValueType, KeyType> Entry;
+    typedef ::Node<Entry> ListNode;
+
+    List<Entry>* m_buckets; 
 
     int m_size;
     int m_capacity;
 
-    static constexpr int INITIAL_CAPACITY = 10007; // Prime number for initial capacity
+    ListNode* m_free_nodes; // Removed list nodes kept for reuse, linked by next
+
+    ThreadPool* m_pool; // Optional, used to rebuild large tables in parallel
+
+    int m_numa_node;    // Preferred node of the bucket array, -1 for first touch
+
+    PLAINS_STAT(mutable HashStats m_stats;)
+
+    static constexpr int PARALLEL_THRESHOLD = 1 << 16; // Smaller tables are rebuilt sequentially
 
     // Compute hash index for a given key
-    int compute_hash(int key) const;
+    int compute_hash(KeyType key) const;
 
     // Expand and rehash the table when load factor is exceeded
     void expand_table();
 
+    // Move every entry into a freshly allocated table of the given capacity
+    void rehash(int new_capacity);
+
+    // A list node holding the pair, recycled from the freelist when possible
+    ListNode* acquire_node(KeyType key, ValueType* value);
+
+    // Hand a node that was unlinked from its bucket back to the freelist
+    void release_node(ListNode* node);
+
+    // Takes count list nodes, from the freelist first. Either all of them are
+    // taken or, if allocating throws, none.
+    void acquire_nodes(ListNode** nodes, int count);
+
+    // Append entries to their buckets in input order, using the given list
+    // nodes. With a thread pool the entries are first partitioned by bucket
+    // range, and every worker then fills its own disjoint range of buckets.
+    // The scratch arrays are allocated before any entry is linked, so if
+    // this throws, the buckets are unchanged.
+    void fill_buckets(List<Entry>* buckets, const KeyType* keys,
+                      ValueType* const* values, ListNode* const* nodes, int count);
+
 public:
 
     // Constructor and destructor
@@ -45,93 +88,363 @@ public:
 
     ~HashMap();
 
+    HashMap(const HashMap&) = delete;
+    HashMap& operator=(const HashMap&) = delete;
+
+    // Grow the table once so that expected_size entries fit without rehashing
+    void reserve(int expected_size);
+
+    // Use the given pool (or nullptr) for bulk inserts and large rehashes
+    void set_thread_pool(ThreadPool* pool);
+
+    // Prefer the given NUMA node for the bucket array, now and after every
+    // rehash (-1: first touch). Chain nodes come from the general heap and
+    // follow the inserting thread.
+    void set_numa_node(int node) {
+        m_numa_node = node;
+        Numa::bind(m_buckets, sizeof(List<Entry>) * static_cast<std::size_t>(m_capacity), node);
+    }
+
+    // Adds the pages of the bucket array to the placement report
+    void add_placement(NumaPlacement& placement) const {
+        placement.add_range(m_buckets, sizeof(List<Entry>) * static_cast<std::size_t>(m_capacity));
+    }
+
+    // Add count pairs whose keys are known not to be in the map yet. May
+    // throw std::bad_alloc, and then with no pair added (the table may have
+    // grown already).
+    void insert_bulk(const KeyType* keys, ValueType* const* values, int count);
+
     // Add a key-value pair to the hash map
-    void insert(int key, ValueType* value); // Ensure ValueType* is used correctly
+    void insert(KeyType key, ValueType* value); // Ensure ValueType* is used correctly
+
+    // Point an existing key at a new value; false if the key is absent.
+    // Never allocates.
+    bool assign(KeyType key, ValueType* value);
 
     // Retrieve values associated with a key
-    ValueType* get_value(int key) const;
+    ValueType* get_value(KeyType key) const;
+
+    // Prefetch hints for batched lookups, issued for a whole group of keys
+    // before any of them is looked up: first the bucket's list header, then
+    // (once that has arrived) the first node of its chain
+    void prefetch_bucket(KeyType key) const {
+        __builtin_prefetch(m_buckets + compute_hash(key));
+    }
+
+    void prefetch_chain(KeyType key) const {
+        const ListNode* node = m_buckets[compute_hash(key)].first();
+        if (node) {
+            __builtin_prefetch(node);
+        }
+    }
 
     // Retrieve values associated with a key
-    ValueType* remove_and_get_values(int key);
+    ValueType* remove_and_get_values(KeyType key);
 
     // Check if a key exists in the hash map
-    bool contains(int key) const;
+    bool contains(KeyType key) const;
 
     // Remove a specific key-value pair
-    bool remove_pair(int key, ValueType* value);
+    bool remove_pair(KeyType key, ValueType* value);
 
     // Get the number of key-value pairs in the hash map
     int get_size() const;
 
     // Check if we have duplicates with the same key
-    bool check_duplicates(const int key) const;
+    bool check_duplicates(const KeyType key) const;
 
     // Delete all nodes in the hash map
     void delate_all_nodes();
+
+    // Call visit(key, value) for every pair, bucket by bucket
+    template<typename Visitor>
+    void for_each(Visitor visit) const {
+        for (int index = 0; index < m_capacity; ++index) {
+            for (const auto& node : m_buckets[index]) {
+                visit(node.m_key, node.m_value);
+            }
+        }
+    }
+
+#ifdef PLAINS_INSTRUMENT
+    // Probe and rehash counters collected so far
+    const HashStats& get_stats() const { return m_stats; }
+
+    int get_capacity() const { return m_capacity; }
+#endif
 };
 
 // Implementations
 
-template<typename ValueType>
-HashMap<ValueType>::HashMap() : m_size(0), m_capacity(INITIAL_CAPACITY) {
-    m_buckets = new List<HashNode<ValueType>>[m_capacity];
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::HashMap() : m_size(0), m_capacity(GrowthPolicy::initial_capacity()), m_free_nodes(nullptr), m_pool(nullptr), m_numa_node(-1) {
+    m_buckets = new List<Entry>[m_capacity];
 }
 
-template<typename ValueType>
-HashMap<ValueType>::~HashMap() {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::~HashMap() {
+    delete[] m_buckets;
+    while (m_free_nodes) {
+        ListNode* next = m_free_nodes->next;
+        delete m_free_nodes;
+        m_free_nodes = next;
+    }
 }
 
-template<typename ValueType>
-int HashMap<ValueType>::compute_hash(int key) const {
-    // Ensure positive index within capacity
-    return ((key % m_capacity) + m_capacity) % m_capacity;
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+typename HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::ListNode*
+HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::acquire_node(KeyType key, ValueType* value) {
+    ListNode* node = m_free_nodes;
+    if (node) {
+        m_free_nodes = node->next;
+        node->next = nullptr;
+    } else {
+        node = new ListNode(Entry());
+    }
+    node->data.m_key = key;
+    node->data.m_value = value;
+    return node;
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::release_node(ListNode* node) {
+    node->prev = nullptr;
+    node->next = m_free_nodes;
+    m_free_nodes = node;
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::acquire_nodes(ListNode** nodes, int count) {
+    int taken = 0;
+    try {
+        for (; taken < count; ++taken) {
+            if (m_free_nodes) {
+                nodes[taken] = m_free_nodes;
+                m_free_nodes = m_free_nodes->next;
+                nodes[taken]->next = nullptr;
+            } else {
+                nodes[taken] = new ListNode(Entry());
+            }
+        }
+    } catch (std::bad_alloc&) {
+        while (taken > 0) {
+            release_node(nodes[--taken]);
+        }
+        throw;
+    }
 }
 
-template<typename ValueType>
-void HashMap<ValueType>::expand_table() {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+int HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::compute_hash(KeyType key) const {
+    return GrowthPolicy::index(HashPolicy::hash(key), m_capacity);
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::expand_table() {
+    rehash(GrowthPolicy::next_capacity(m_capacity));
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::rehash(int new_capacity) {
+    PLAINS_STAT(m_stats.m_rehashes++;)
+    PLAINS_STAT(ScopedTimer rehash_timer(m_stats.m_rehash_ns);)
     int old_capacity = m_capacity;
-    m_capacity *= 2;
-    List<HashNode<ValueType>>* new_buckets = new List<HashNode<ValueType>>[m_capacity];
-
-    for (int i = 0; i < old_capacity; ++i) {
-        // Traverse the existing bucket
-        for(auto& node : m_buckets[i]){
-            if(node.m_key != 0 || node.m_value != nullptr){
-                int new_index = compute_hash(node.m_key);
-                new_buckets[new_index].push_back(node);
+    List<Entry>* old_buckets = m_buckets;
+    unique_ptr<List<Entry>[]> new_buckets(new List<Entry>[new_capacity]);
+    if (m_numa_node >= 0) {
+        Numa::bind(new_buckets.get(), sizeof(List<Entry>) * static_cast<std::size_t>(new_capacity), m_numa_node);
+    }
+
+    // Existing list nodes are relinked into the new buckets, so apart from
+    // the bucket array (and the chain heads below) nothing is allocated
+    if (m_pool && m_size >= PARALLEL_THRESHOLD) {
+        // Every worker first moves the nodes of its range of old buckets to
+        // one chain per destination range, then every worker drains the chains
+        // of its destination range. Chains are drained in source order, so
+        // each new bucket gets the same order as the sequential loop below.
+        const int parts = m_pool->get_thread_count();
+        const int oldPerPart = (old_capacity + parts - 1) / parts;
+        const int newPerPart = (new_capacity + parts - 1) / parts;
+        unique_ptr<List<Entry>[]> chains(new List<Entry>[parts * parts]);
+        m_capacity = new_capacity;
+        m_pool->parallel_for(parts, 1, [&](int begin, int end) {
+            for (int source = begin; source < end; ++source) {
+                List<Entry>* sourceChains = chains.get() + source * parts;
+                int last = oldPerPart * (source + 1) < old_capacity ? oldPerPart * (source + 1) : old_capacity;
+                for (int i = oldPerPart * source; i < last; ++i) {
+                    while (ListNode* node = old_buckets[i].unlink_front()) {
+                        sourceChains[compute_hash(node->data.m_key) / newPerPart].link_back(node);
+                    }
+                }
+            }
+        });
+        m_pool->parallel_for(parts, 1, [&](int begin, int end) {
+            for (int target = begin; target < end; ++target) {
+                for (int source = 0; source < parts; ++source) {
+                    List<Entry>& chain = chains[source * parts + target];
+                    while (ListNode* node = chain.unlink_front()) {
+                        new_buckets[compute_hash(node->data.m_key)].link_back(node);
+                    }
+                }
+            }
+        });
+    } else {
+        m_capacity = new_capacity;
+        for (int i = 0; i < old_capacity; ++i) {
+            // Move the nodes of the existing bucket over
+            while (ListNode* node = old_buckets[i].unlink_front()) {
+                new_buckets[compute_hash(node->data.m_key)].link_back(node);
             }
         }
     }
 
-    delete[] m_buckets;
-    m_buckets = new_buckets;
+    delete[] old_buckets;
+    m_buckets = new_buckets.release();
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::fill_buckets(List<Entry>* buckets, const KeyType* keys,
+                                      ValueType* const* values, ListNode* const* nodes, int count) {
+    if (!m_pool || count < PARALLEL_THRESHOLD) {
+        for (int i = 0; i < count; ++i) {
+            nodes[i]->data.m_key = keys[i];
+            nodes[i]->data.m_value = values[i];
+            buckets[compute_hash(keys[i])].link_back(nodes[i]);
+        }
+        return;
+    }
+
+    // Radix partition by bucket range: chunk c counts its entries per part,
+    // then scatters them stably so each part keeps the input order
+    const int parts = m_pool->get_thread_count();
+    const int chunkSize = (count + parts - 1) / parts;
+    const int bucketsPerPart = (m_capacity + parts - 1) / parts;
+    unique_ptr<int[]> offsets(new int[parts * parts]);
+    m_pool->parallel_for(parts, 1, [&](int begin, int end) {
+        for (int chunk = begin; chunk < end; ++chunk) {
+            int* counts = offsets.get() + chunk * parts;
+            for (int part = 0; part < parts; ++part) {
+                counts[part] = 0;
+            }
+            int last = chunkSize * (chunk + 1) < count ? chunkSize * (chunk + 1) : count;
+            for (int i = chunkSize * chunk; i < last; ++i) {
+                counts[compute_hash(keys[i]) / bucketsPerPart]++;
+            }
+        }
+    });
+    unique_ptr<int[]> partStart(new int[parts + 1]);
+    int running = 0;
+    for (int part = 0; part < parts; ++part) {
+        partStart[part] = running;
+        for (int chunk = 0; chunk < parts; ++chunk) {
+            int chunkCount = offsets[chunk * parts + part];
+            offsets[chunk * parts + part] = running;
+            running += chunkCount;
+        }
+    }
+    partStart[parts] = running;
+
+    unique_ptr<KeyType[]> sortedKeys(new KeyType[count]);
+    unique_ptr<ValueType*[]> sortedValues(new ValueType*[count]);
+    m_pool->parallel_for(parts, 1, [&](int begin, int end) {
+        for (int chunk = begin; chunk < end; ++chunk) {
+            int* next = offsets.get() + chunk * parts;
+            int last = chunkSize * (chunk + 1) < count ? chunkSize * (chunk + 1) : count;
+            for (int i = chunkSize * chunk; i < last; ++i) {
+                int position = next[compute_hash(keys[i]) / bucketsPerPart]++;
+                sortedKeys[position] = keys[i];
+                sortedValues[position] = values[i];
+            }
+        }
+    });
+
+    m_pool->parallel_for(parts, 1, [&](int begin, int end) {
+        for (int part = begin; part < end; ++part) {
+            for (int i = partStart[part]; i < partStart[part + 1]; ++i) {
+                nodes[i]->data.m_key = sortedKeys[i];
+                nodes[i]->data.m_value = sortedValues[i];
+                buckets[compute_hash(sortedKeys[i])].link_back(nodes[i]);
+            }
+        }
+    });
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::set_thread_pool(ThreadPool* pool) {
+    m_pool = pool;
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::insert_bulk(const KeyType* keys, ValueType* const* values, int count) {
+    if (count <= 0) {
+        return;
+    }
+    // Everything that can throw happens before the first entry is linked
+    reserve(m_size + count);
+    unique_ptr<ListNode*[]> nodes(new ListNode*[count]);
+    acquire_nodes(nodes.get(), count);
+    try {
+        fill_buckets(m_buckets, keys, values, nodes.get(), count);
+    } catch (std::bad_alloc&) {
+        for (int i = 0; i < count; ++i) {
+            release_node(nodes[i]);
+        }
+        throw;
+    }
+    m_size += count;
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::reserve(int expected_size) {
+    // Keep the load factor within LOAD_NUM / LOAD_DEN once expected_size entries are in
+    long long needed = static_cast<long long>(expected_size) * LOAD_DEN / LOAD_NUM + 1;
+    if (needed <= m_capacity) {
+        return;
+    }
+    rehash(GrowthPolicy::capacity_for(needed));
 }
 
-template<typename ValueType>
-void HashMap<ValueType>::insert(int key, ValueType* value) {
-    if (static_cast<float>(m_size) / m_capacity > 0.75f) {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+void HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::insert(KeyType key, ValueType* value) {
+    if (static_cast<long long>(m_size) * LOAD_DEN > static_cast<long long>(m_capacity) * LOAD_NUM) {
         expand_table();
     }
 
     int index = compute_hash(key);
+    PLAINS_STAT(ProbeCounter probes(m_stats);)
     for(auto& node : m_buckets[index]){
+        PLAINS_STAT(probes.step();)
         if(node.m_key == key){
             node.m_value = value;
             return;
         }
     }
 
-    HashNode<ValueType> new_node;
-    new_node.m_key = key;
-    new_node.m_value = value;
-    m_buckets[index].push_back(new_node);
+    m_buckets[index].link_back(acquire_node(key, value));
     m_size++;
 }
 
-template<typename ValueType>
-ValueType* HashMap<ValueType>::get_value(int key) const {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+bool HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::assign(KeyType key, ValueType* value) {
+    int index = compute_hash(key);
+    PLAINS_STAT(ProbeCounter probes(m_stats);)
+    for(auto& node : m_buckets[index]){
+        PLAINS_STAT(probes.step();)
+        if(node.m_key == key){
+            node.m_value = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+ValueType* HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::get_value(KeyType key) const {
     int index = compute_hash(key);
+    PLAINS_STAT(ProbeCounter probes(m_stats);)
     for(const auto& node : m_buckets[index]){
+        PLAINS_STAT(probes.step();)
         if(node.m_key == key){
             return node.m_value;
         }
@@ -139,13 +452,15 @@ ValueType* HashMap<ValueType>::get_value(int key) const {
     return nullptr;
 }
 
-template<typename ValueType>
-ValueType* HashMap<ValueType>::remove_and_get_values(int key) {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+ValueType* HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::remove_and_get_values(KeyType key) {
     int index = compute_hash(key);
+    PLAINS_STAT(ProbeCounter probes(m_stats);)
     for(auto it = m_buckets[index].begin(); it != m_buckets[index].end(); ++it){
+        PLAINS_STAT(probes.step();)
         if((*it).m_key == key){
             ValueType* value = (*it).m_value;
-            m_buckets[index].remove(*it);
+            release_node(m_buckets[index].unlink(it.node()));
             m_size--;
             return value;
         }
@@ -153,10 +468,12 @@ ValueType* HashMap<ValueType>::remove_and_get_values(int key) {
     return nullptr;
 }
 
-template<typename ValueType>
-bool HashMap<ValueType>::contains(int key) const {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+bool HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::contains(KeyType key) const {
     int index = compute_hash(key);
+    PLAINS_STAT(ProbeCounter probes(m_stats);)
     for(const auto& node : m_buckets[index]){
+        PLAINS_STAT(probes.step();)
         if(node.m_key == key){
             return true;
         }
@@ -164,12 +481,14 @@ bool HashMap<ValueType>::contains(int key) const {
     return false;
 }
 
-template<typename ValueType>
-bool HashMap<ValueType>::remove_pair(int key, ValueType* node) {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+bool HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::remove_pair(KeyType key, ValueType* node) {
     int index = compute_hash(key);
+    PLAINS_STAT(ProbeCounter probes(m_stats);)
     for(auto it = m_buckets[index].begin(); it != m_buckets[index].end(); ++it){
+        PLAINS_STAT(probes.step();)
         if(it->m_key == key && it->m_value == node){
-            m_buckets[index].remove(*it);
+            release_node(m_buckets[index].unlink(it.node()));
             m_size--;
             return true;
         }
@@ -178,16 +497,18 @@ bool HashMap<ValueType>::remove_pair(int key, ValueType* node) {
 }
 
 
-template<typename ValueType>
-int HashMap<ValueType>::get_size() const {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+int HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::get_size() const {
     return m_size;
 }
 
-template<typename ValueType>
-bool HashMap<ValueType>::check_duplicates(const int key) const {
+template<typename ValueType, typename KeyType, typename HashPolicy, typename GrowthPolicy, int LOAD_NUM, int LOAD_DEN>
+bool HashMap<ValueType, KeyType, HashPolicy, GrowthPolicy, LOAD_NUM, LOAD_DEN>::check_duplicates(const KeyType key) const {
     int index = compute_hash(key);
     int count = 0;
+    PLAINS_STAT(ProbeCounter probes(m_stats);)
     for(const auto& node : m_buckets[index]){
+        PLAINS_STAT(probes.step();)
         if(node.m_key == key){
             count++;
             if(count > 1){
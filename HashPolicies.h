@@ -0,0 +1,107 @@
+#ifndef HASH_POLICIES_H
+#define HASH_POLICIES_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Compile-time policies for HashMap.
+//
+// A hash policy turns a key into an unsigned hash value:
+//     static std::size_t hash(KeyType key);
+// A growth policy decides the table capacities and maps a hash to a bucket:
+//     static int initial_capacity();
+//     static int next_capacity(int capacity);      // Used on expansion
+//     static int capacity_for(long long needed);   // Smallest capacity >= needed
+//     static int index(std::size_t hash, int capacity);
+
+// Uses the key itself; fine for prime tables and for dense sequential IDs
+struct IdentityHash {
+    static std::size_t hash(int key) {
+        return static_cast<std::size_t>(static_cast<unsigned int>(key));
+    }
+
+    static std::size_t hash(long long key) {
+        return static_cast<std::size_t>(static_cast<unsigned long long>(key));
+    }
+};
+
+// Fibonacci (multiplicative) hashing: multiply by 2^64 / phi and keep the
+// high bits, so power-of-two tables see well mixed low bits
+struct FibonacciHash {
+    static std::size_t hash(int key) {
+        return static_cast<std::size_t>(
+            (static_cast<uint64_t>(static_cast<unsigned int>(key)) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+
+    static std::size_t hash(long long key) {
+        return static_cast<std::size_t>(
+            (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+};
+
+// Prime table sizes, roughly doubling; one modulo per lookup
+struct PrimeGrowth {
+    static int initial_capacity() {
+        return primes()[0];
+    }
+
+    static int next_capacity(int capacity) {
+        return capacity_for(static_cast<long long>(capacity) + 1);
+    }
+
+    static int capacity_for(long long needed) {
+        const int* table = primes();
+        for (int i = 0; i < PRIME_COUNT; ++i) {
+            if (table[i] >= needed) {
+                return table[i];
+            }
+        }
+        return table[PRIME_COUNT - 1];
+    }
+
+    static int index(std::size_t hash, int capacity) {
+        return static_cast<int>(hash % static_cast<std::size_t>(capacity));
+    }
+
+private:
+    static constexpr int PRIME_COUNT = 18;
+
+    static const int* primes() {
+        static const int table[PRIME_COUNT] = {
+            10007, 20021, 40063, 80141, 160309, 320627, 641261, 1282529, 2565061,
+            5130143, 10260301, 20520629, 41041267, 82082537, 164165083, 328330169,
+            656660401, 1313320807
+        };
+        return table;
+    }
+};
+
+// Power-of-two table sizes; the bucket is a mask of the hash, no division
+template<int INITIAL = 16384>
+struct PowerOfTwoGrowthPolicy {
+    static_assert(INITIAL > 0 && (INITIAL & (INITIAL - 1)) == 0, "capacity must be a power of two");
+
+    static int initial_capacity() {
+        return INITIAL;
+    }
+
+    static int next_capacity(int capacity) {
+        return capacity < (1 << 30) ? capacity * 2 : capacity;
+    }
+
+    static int capacity_for(long long needed) {
+        long long capacity = INITIAL;
+        while (capacity < needed && capacity < (1 << 30)) {
+            capacity *= 2;
+        }
+        return static_cast<int>(capacity);
+    }
+
+    static int index(std::size_t hash, int capacity) {
+        return static_cast<int>(hash & static_cast<std::size_t>(capacity - 1));
+    }
+};
+
+typedef PowerOfTwoGrowthPolicy<> PowerOfTwoGrowth;
+
+#endif // HASH_POLICIES_H
@@ -0,0 +1,172 @@
+#ifndef ID_SET_H
+#define ID_SET_H
+
+#include <cstdint>
+#include <new>
+
+#include "FlatTable.h"
+
+// Set of int IDs (> 0) laid out like a Roaring bitmap. IDs are split by
+// their high 16 bits into chunks, found through a FlatTable; a chunk keeps
+// the low 16 bits of its IDs as a sorted uint16_t array while it holds at
+// most ARRAY_LIMIT of them (2 bytes per ID), and as a 65536-bit bitmap
+// (8 KB, the size of a full array) once it is denser. Sparse IDs scattered
+// over the whole int range cost a few bytes each, dense ranges one bit each.
+//
+// IDs are only ever added. Like RecordHistory, insertion is split in two:
+// prepare() allocates whatever the next insert of that ID needs and may
+// throw, insert() never fails, so callers can reserve before changing
+// anything else.
+class IdSet {
+private:
+    static constexpr int ARRAY_LIMIT = 4096;
+    static constexpr int BITMAP_WORDS = 65536 / 64;
+    static constexpr int MIN_ARRAY = 4;
+
+    struct Chunk {
+        int m_id;               // High 16 bits + 1
+        int m_count;
+        int m_capacity;         // Array entries, 0 once a bitmap
+        uint16_t* m_array;      // Sorted low bits, or nullptr
+        uint64_t* m_bits;       // Bitmap, or nullptr
+    };
+
+    FlatTable<Chunk> m_chunks;
+    int m_size;
+    int m_bitmaps;
+    long long m_array_entries;  // Capacity of all arrays together
+
+    static int chunk_id(int id) {
+        return (static_cast<int>(static_cast<uint32_t>(id) >> 16)) + 1;
+    }
+
+    static uint16_t low_bits(int id) {
+        return static_cast<uint16_t>(id & 0xFFFF);
+    }
+
+    // First array entry not below low
+    static int lower_bound(const Chunk& chunk, uint16_t low) {
+        int begin = 0;
+        int end = chunk.m_count;
+        while (begin < end) {
+            int middle = (begin + end) / 2;
+            if (chunk.m_array[middle] < low) {
+                begin = middle + 1;
+            } else {
+                end = middle;
+            }
+        }
+        return begin;
+    }
+
+    void to_bitmap(Chunk& chunk) {
+        uint64_t* bits = new uint64_t[BITMAP_WORDS]();
+        for (int i = 0; i < chunk.m_count; ++i) {
+            bits[chunk.m_array[i] >> 6] |= 1ull << (chunk.m_array[i] & 63);
+        }
+        delete[] chunk.m_array;
+        m_array_entries -= chunk.m_capacity;
+        chunk.m_array = nullptr;
+        chunk.m_capacity = 0;
+        chunk.m_bits = bits;
+        m_bitmaps++;
+    }
+
+    void grow_array(Chunk& chunk) {
+        int capacity = chunk.m_capacity ? 2 * chunk.m_capacity : MIN_ARRAY;
+        capacity = capacity > ARRAY_LIMIT ? ARRAY_LIMIT : capacity;
+        uint16_t* array = new uint16_t[capacity];
+        for (int i = 0; i < chunk.m_count; ++i) {
+            array[i] = chunk.m_array[i];
+        }
+        delete[] chunk.m_array;
+        m_array_entries += capacity - chunk.m_capacity;
+        chunk.m_array = array;
+        chunk.m_capacity = capacity;
+    }
+
+public:
+    IdSet() : m_chunks(), m_size(0), m_bitmaps(0), m_array_entries(0) {}
+
+    ~IdSet() {
+        for (int i = 0; i < m_chunks.get_capacity(); ++i) {
+            Chunk* chunk = m_chunks.slot(i);
+            if (chunk) {
+                delete[] chunk->m_array;
+                delete[] chunk->m_bits;
+            }
+        }
+    }
+
+    IdSet(const IdSet&) = delete;
+    IdSet& operator=(const IdSet&) = delete;
+
+    bool contains(int id) const {
+        const Chunk* chunk = m_chunks.find(chunk_id(id));
+        if (!chunk) {
+            return false;
+        }
+        uint16_t low = low_bits(id);
+        if (chunk->m_bits) {
+            return (chunk->m_bits[low >> 6] >> (low & 63)) & 1;
+        }
+        int index = lower_bound(*chunk, low);
+        return index < chunk->m_count && chunk->m_array[index] == low;
+    }
+
+    // Makes sure insert(id) cannot fail. May throw std::bad_alloc, leaving
+    // at most an empty chunk or a chunk in its other layout behind.
+    void prepare(int id) {
+        Chunk* chunk = m_chunks.find(chunk_id(id));
+        if (!chunk) {
+            chunk = m_chunks.insert(chunk_id(id));
+            chunk->m_count = 0;
+            chunk->m_capacity = 0;
+            chunk->m_array = nullptr;
+            chunk->m_bits = nullptr;
+        }
+        if (chunk->m_bits || chunk->m_count < chunk->m_capacity) {
+            return;
+        }
+        if (chunk->m_count == ARRAY_LIMIT) {
+            to_bitmap(*chunk);
+        } else {
+            grow_array(*chunk);
+        }
+    }
+
+    // Adds id (no-op if present); prepare(id) must have been called since
+    // the last insert into the same chunk
+    void insert(int id) {
+        Chunk& chunk = *m_chunks.find(chunk_id(id));
+        uint16_t low = low_bits(id);
+        if (chunk.m_bits) {
+            uint64_t bit = 1ull << (low & 63);
+            if (!(chunk.m_bits[low >> 6] & bit)) {
+                chunk.m_bits[low >> 6] |= bit;
+                chunk.m_count++;
+                m_size++;
+            }
+            return;
+        }
+        int index = lower_bound(chunk, low);
+        if (index < chunk.m_count && chunk.m_array[index] == low) {
+            return;
+        }
+        for (int i = chunk.m_count; i > index; --i) {
+            chunk.m_array[i] = chunk.m_array[i - 1];
+        }
+        chunk.m_array[index] = low;
+        chunk.m_count++;
+        m_size++;
+    }
+
+    int get_size() const { return m_size; }
+
+    long long memory_bytes() const {
+        return m_chunks.memory_bytes() + m_array_entries * static_cast<long long>(sizeof(uint16_t)) +
+               static_cast<long long>(m_bitmaps) * BITMAP_WORDS * static_cast<long long>(sizeof(uint64_t));
+    }
+};
+
+#endif // ID_SET_H
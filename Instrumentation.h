@@ -0,0 +1,230 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+// Hot-path instrumentation for Plains and HashMap.
+// Everything here is compiled in only when PLAINS_INSTRUMENT is defined
+// (e.g. g++ -DPLAINS_INSTRUMENT ...). Otherwise PLAINS_STAT(...) expands to
+// nothing, PlainsStats is an empty stand-in, and no counter, timer or
+// histogram exists in the binary.
+
+#include <ostream>
+
+#ifdef PLAINS_INSTRUMENT
+
+#include <chrono>
+#include <cstdint>
+
+#define PLAINS_STAT(statement) statement
+
+// Log-linear (HDR style) histogram of non-negative 64-bit values.
+// Values are grouped by their highest set bit and split into 2^SUB_BITS
+// linear sub-buckets, which keeps the relative error below 2^-SUB_BITS.
+class LatencyHistogram {
+private:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int SUB_COUNT = 1 << SUB_BITS;
+    static constexpr int BUCKET_COUNT = (64 - SUB_BITS + 1) * SUB_COUNT;
+
+    uint64_t m_buckets[BUCKET_COUNT];
+    uint64_t m_count;
+    uint64_t m_total;
+    uint64_t m_max;
+
+    static int bucket_of(uint64_t value) {
+        if (value < static_cast<uint64_t>(SUB_COUNT)) {
+            return static_cast<int>(value);
+        }
+        int highBit = 63 - __builtin_clzll(value);
+        int group = highBit - SUB_BITS + 1;
+        int sub = static_cast<int>((value >> (highBit - SUB_BITS)) & (SUB_COUNT - 1));
+        return group * SUB_COUNT + sub;
+    }
+
+    // Smallest value that falls into the given bucket
+    static uint64_t lower_bound_of(int bucket) {
+        int group = bucket / SUB_COUNT;
+        uint64_t sub = static_cast<uint64_t>(bucket % SUB_COUNT);
+        if (group == 0) {
+            return sub;
+        }
+        int highBit = group + SUB_BITS - 1;
+        return (static_cast<uint64_t>(1) << highBit) | (sub << (highBit - SUB_BITS));
+    }
+
+public:
+    LatencyHistogram() : m_count(0), m_total(0), m_max(0) {
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            m_buckets[i] = 0;
+        }
+    }
+
+    void record(uint64_t value) {
+        m_buckets[bucket_of(value)]++;
+        m_count++;
+        m_total += value;
+        if (value > m_max) {
+            m_max = value;
+        }
+    }
+
+    uint64_t get_count() const { return m_count; }
+    uint64_t get_max() const { return m_max; }
+
+    double get_mean() const {
+        return m_count ? static_cast<double>(m_total) / m_count : 0.0;
+    }
+
+    // Value at the given percentile (0..100), rounded down to its bucket
+    uint64_t get_percentile(double percentile) const {
+        if (m_count == 0) {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * m_count);
+        if (rank >= m_count) {
+            rank = m_count - 1;
+        }
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += m_buckets[i];
+            if (seen > rank) {
+                uint64_t value = lower_bound_of(i);
+                return value < m_max ? value : m_max;
+            }
+        }
+        return m_max;
+    }
+
+    void write_json(std::ostream& os) const {
+        os << "{\"count\": " << m_count
+           << ", \"mean\": " << get_mean()
+           << ", \"p50\": " << get_percentile(50)
+           << ", \"p90\": " << get_percentile(90)
+           << ", \"p99\": " << get_percentile(99)
+           << ", \"p999\": " << get_percentile(99.9)
+           << ", \"max\": " << m_max << "}";
+    }
+};
+
+// Counters kept by every HashMap
+struct HashStats {
+    uint64_t m_lookups;         // Bucket walks of any kind
+    uint64_t m_probes;          // Chain nodes visited by those walks
+    uint64_t m_max_probe;       // Longest single walk
+    uint64_t m_rehashes;
+    LatencyHistogram m_rehash_ns;
+
+    HashStats() : m_lookups(0), m_probes(0), m_max_probe(0), m_rehashes(0), m_rehash_ns() {}
+
+    void record_walk(uint64_t probes) {
+        m_lookups++;
+        m_probes += probes;
+        if (probes > m_max_probe) {
+            m_max_probe = probes;
+        }
+    }
+
+    void write_json(std::ostream& os, int size, int capacity) const {
+        os << "{\"size\": " << size
+           << ", \"capacity\": " << capacity
+           << ", \"lookups\": " << m_lookups
+           << ", \"probes\": " << m_probes
+           << ", \"avg_probes\": " << (m_lookups ? static_cast<double>(m_probes) / m_lookups : 0.0)
+           << ", \"max_probe\": " << m_max_probe
+           << ", \"rehashes\": " << m_rehashes
+           << ", \"rehash_ns\": ";
+        m_rehash_ns.write_json(os);
+        os << "}";
+    }
+};
+
+// Counts the chain nodes visited by one bucket walk and records the walk
+// into the owning HashStats when it goes out of scope
+class ProbeCounter {
+private:
+    HashStats& m_stats;
+    uint64_t m_probes;
+
+public:
+    explicit ProbeCounter(HashStats& stats) : m_stats(stats), m_probes(0) {}
+
+    ~ProbeCounter() {
+        m_stats.record_walk(m_probes);
+    }
+
+    void step() {
+        m_probes++;
+    }
+
+    ProbeCounter(const ProbeCounter&) = delete;
+    ProbeCounter& operator=(const ProbeCounter&) = delete;
+};
+
+// Records the lifetime of the enclosing scope (in nanoseconds) into a histogram
+class ScopedTimer {
+private:
+    LatencyHistogram& m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+
+public:
+    explicit ScopedTimer(LatencyHistogram& histogram)
+        : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - m_start;
+        m_histogram.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+// Counters kept by Plains itself
+struct PlainsStats {
+    enum Operation {
+        ADD_TEAM,
+        ADD_JOCKEY,
+        UPDATE_MATCH,
+        MERGE_TEAMS,
+        UNITE_BY_RECORD,
+        GET_JOCKEY_RECORD,
+        GET_TEAM_RECORD,
+        OPERATION_COUNT
+    };
+
+    LatencyHistogram m_operation_ns[OPERATION_COUNT];
+    LatencyHistogram m_find_path;   // Parent links followed per find_root
+
+    // Records how many parent links lead from node to its root
+    template<typename Node>
+    void record_find_path(const Node* node) {
+        int length = 0;
+        while (node && node->m_parent != node) {
+            node = node->m_parent;
+            length++;
+        }
+        m_find_path.record(length);
+    }
+
+    static const char* operation_name(int operation) {
+        static const char* const names[OPERATION_COUNT] = {
+            "add_team", "add_jockey", "update_match", "merge_teams",
+            "unite_by_record", "get_jockey_record", "get_team_record"
+        };
+        return names[operation];
+    }
+};
+
+#else
+
+#define PLAINS_STAT(statement)
+
+// Counters kept by Plains itself: none
+struct PlainsStats {
+    template<typename Node>
+    void record_find_path(const Node*) {}
+};
+
+#endif // PLAINS_INSTRUMENT
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,424 @@
+#include "LeagueRegistry.h"
+
+LeagueRegistry::LeagueRegistry()
+    : m_leagues(), m_team_map(), m_jockey_map(), m_record_map(),
+      m_league_slab(), m_node_slab(), m_record_slab(), m_pool(), m_numa_node(-1) {
+}
+
+// The slabs go away with the registry; nodes, slots and leagues are all
+// trivially destructible, so nothing has to be walked.
+LeagueRegistry::~LeagueRegistry() {
+}
+
+LeagueRegistry::LeagueNode* LeagueRegistry::find_root(LeagueNode* node) {
+    LeagueNode* root = node;
+    while (root->m_parent != root) {
+        root = root->m_parent;
+    }
+    while (node != root) {
+        LeagueNode* next = node->m_parent;
+        node->m_parent = root;
+        node = next;
+    }
+    return root;
+}
+
+LeagueRegistry::LeagueNode* LeagueRegistry::find_team(int leagueId, int teamId) const {
+    LeagueNode* node = m_team_map.get_value(league_key(leagueId, teamId));
+    // After a merge the absorbed ID still maps to a node, but that node is
+    // either no longer a root or the root carries the other team's ID
+    if (!node || node->m_parent != node || node->m_team_id != teamId) {
+        return nullptr;
+    }
+    return node;
+}
+
+void LeagueRegistry::record_add(League* league, int leagueId, int record, int teamId) {
+    long long key = league_key(leagueId, record);
+    RecordSlot* slot = m_record_map.get_value(key);
+    if (!slot) {
+        slot = m_record_slab.create();
+        try {
+            m_record_map.insert(key, slot);
+        } catch (std::bad_alloc&) {
+            m_record_slab.release(slot);
+            throw;
+        }
+        league->m_record_count++;
+    }
+    slot->m_count++;
+    slot->m_id_xor ^= teamId;
+}
+
+void LeagueRegistry::record_remove(League* league, int leagueId, int record, int teamId) {
+    long long key = league_key(leagueId, record);
+    RecordSlot* slot = m_record_map.get_value(key);
+    if (!slot) {
+        return;
+    }
+    slot->m_id_xor ^= teamId;
+    if (--slot->m_count == 0) {
+        m_record_map.remove_and_get_values(key);
+        m_record_slab.release(slot);
+        league->m_record_count--;
+    }
+}
+
+// Creates an empty league.
+
+// Parameters:
+// • leagueId: the ID of the new league.
+
+// Return value:
+// • ALLOCATION_ERROR in case of a memory allocation/release problem.
+// • INVALID_INPUT if leagueId <= 0.
+// • FAILURE if a league with ID leagueId exists.
+// • SUCCESS on success.
+// Time complexity: O(1) on average.
+StatusType LeagueRegistry::create_league(int leagueId) {
+    if (leagueId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        if (m_leagues.get_value(leagueId)) {
+            return StatusType::FAILURE;
+        }
+        League* league = m_league_slab.create();
+        try {
+            m_leagues.insert(leagueId, league);
+        } catch (std::bad_alloc&) {
+            m_league_slab.release(league);
+            throw;
+        }
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Destroys a league and everything in it. Its IDs become free again.
+
+// Parameters:
+// • leagueId: the ID of the league.
+
+// Return value:
+// • INVALID_INPUT if leagueId <= 0.
+// • FAILURE if there is no league with ID leagueId.
+// • SUCCESS on success.
+// Time complexity: O(n + m) on average, for the league's n teams and m riders.
+StatusType LeagueRegistry::destroy_league(int leagueId) {
+    if (leagueId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    League* league = m_leagues.remove_and_get_values(leagueId);
+    if (!league) {
+        return StatusType::FAILURE;
+    }
+    LeagueNode* node = league->m_teams;
+    while (node) {
+        LeagueNode* next = node->m_next;
+        if (node->m_parent == node) {
+            record_remove(league, leagueId, node->m_record, node->m_team_id);
+        }
+        m_team_map.remove_and_get_values(league_key(leagueId, node->m_id));
+        m_node_slab.release(node);
+        node = next;
+    }
+    node = league->m_jockeys;
+    while (node) {
+        LeagueNode* next = node->m_next;
+        m_jockey_map.remove_and_get_values(league_key(leagueId, node->m_id));
+        m_node_slab.release(node);
+        node = next;
+    }
+    m_league_slab.release(league);
+    return StatusType::SUCCESS;
+}
+
+// Same as Plains::add_team, inside league leagueId.
+// Time complexity: O(1) on average.
+StatusType LeagueRegistry::add_team(int leagueId, int teamId) {
+    if (leagueId <= 0 || teamId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        League* league = m_leagues.get_value(leagueId);
+        long long key = league_key(leagueId, teamId);
+        if (!league || m_team_map.get_value(key)) {
+            return StatusType::FAILURE;
+        }
+        LeagueNode* node = m_node_slab.create(teamId, league->m_teams);
+        try {
+            record_add(league, leagueId, 0, teamId);
+            try {
+                m_team_map.insert(key, node);
+            } catch (std::bad_alloc&) {
+                record_remove(league, leagueId, 0, teamId);
+                throw;
+            }
+        } catch (std::bad_alloc&) {
+            m_node_slab.release(node);
+            throw;
+        }
+        league->m_teams = node;
+        league->m_team_count++;
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Same as Plains::add_jockey, inside league leagueId.
+// Time complexity: O(1) on average.
+StatusType LeagueRegistry::add_jockey(int leagueId, int jockeyId, int teamId) {
+    if (leagueId <= 0 || jockeyId <= 0 || teamId <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        League* league = m_leagues.get_value(leagueId);
+        if (!league) {
+            return StatusType::FAILURE;
+        }
+        long long key = league_key(leagueId, jockeyId);
+        LeagueNode* team = find_team(leagueId, teamId);
+        if (m_jockey_map.get_value(key) || !team) {
+            return StatusType::FAILURE;
+        }
+        LeagueNode* node = m_node_slab.create(jockeyId, league->m_jockeys);
+        try {
+            m_jockey_map.insert(key, node);
+        } catch (std::bad_alloc&) {
+            m_node_slab.release(node);
+            throw;
+        }
+        node->m_parent = team;
+        team->m_size++;
+        league->m_jockeys = node;
+        league->m_jockey_count++;
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Same as Plains::update_match, inside league leagueId.
+// Time complexity: O(log* m) amortized.
+StatusType LeagueRegistry::update_match(int leagueId, int victoriousJockeyId, int losingJockeyId) {
+    if (leagueId <= 0 || victoriousJockeyId <= 0 || losingJockeyId <= 0 ||
+        victoriousJockeyId == losingJockeyId) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        League* league = m_leagues.get_value(leagueId);
+        if (!league) {
+            return StatusType::FAILURE;
+        }
+        LeagueNode* winner = m_jockey_map.get_value(league_key(leagueId, victoriousJockeyId));
+        LeagueNode* loser = m_jockey_map.get_value(league_key(leagueId, losingJockeyId));
+        if (!winner || !loser) {
+            return StatusType::FAILURE;
+        }
+        LeagueNode* winnerTeam = find_root(winner);
+        LeagueNode* loserTeam = find_root(loser);
+        if (winnerTeam == loserTeam) {
+            return StatusType::FAILURE;
+        }
+        // Add the new records first: only that can fail
+        record_add(league, leagueId, winnerTeam->m_record + 1, winnerTeam->m_team_id);
+        try {
+            record_add(league, leagueId, loserTeam->m_record - 1, loserTeam->m_team_id);
+        } catch (std::bad_alloc&) {
+            record_remove(league, leagueId, winnerTeam->m_record + 1, winnerTeam->m_team_id);
+            throw;
+        }
+        record_remove(league, leagueId, winnerTeam->m_record, winnerTeam->m_team_id);
+        record_remove(league, leagueId, loserTeam->m_record, loserTeam->m_team_id);
+        winner->m_record++;
+        loser->m_record--;
+        winnerTeam->m_record++;
+        loserTeam->m_record--;
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Same as Plains::merge_teams, inside league leagueId: the team with the
+// better record (teamId1 on a tie) keeps its ID.
+// Time complexity: O(1) on average.
+StatusType LeagueRegistry::merge_teams(int leagueId, int teamId1, int teamId2) {
+    if (leagueId <= 0 || teamId1 <= 0 || teamId2 <= 0 || teamId1 == teamId2) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        League* league = m_leagues.get_value(leagueId);
+        if (!league) {
+            return StatusType::FAILURE;
+        }
+        LeagueNode* team1 = find_team(leagueId, teamId1);
+        LeagueNode* team2 = find_team(leagueId, teamId2);
+        if (!team1 || !team2) {
+            return StatusType::FAILURE;
+        }
+        int survivorId = team2->m_record > team1->m_record ? teamId2 : teamId1;
+        int record = team1->m_record + team2->m_record;
+
+        // Union by size; the surviving ID moves to whichever node is the root
+        LeagueNode* root = team1;
+        LeagueNode* child = team2;
+        if (root->m_size < child->m_size) {
+            root = team2;
+            child = team1;
+        }
+        long long survivorKey = league_key(leagueId, survivorId);
+        record_add(league, leagueId, record, survivorId);
+        try {
+            if (root->m_id != survivorId) {
+                m_team_map.insert(survivorKey, root);
+            }
+        } catch (std::bad_alloc&) {
+            record_remove(league, leagueId, record, survivorId);
+            throw;
+        }
+        record_remove(league, leagueId, team1->m_record, teamId1);
+        record_remove(league, leagueId, team2->m_record, teamId2);
+        child->m_parent = root;
+        root->m_size += child->m_size;
+        root->m_record = record;
+        root->m_team_id = survivorId;
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Same as Plains::unite_by_record, inside league leagueId.
+// Time complexity: O(1) on average.
+StatusType LeagueRegistry::unite_by_record(int leagueId, int record) {
+    if (leagueId <= 0 || record <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    if (!m_leagues.get_value(leagueId)) {
+        return StatusType::FAILURE;
+    }
+    RecordSlot* positive = m_record_map.get_value(league_key(leagueId, record));
+    RecordSlot* negative = m_record_map.get_value(league_key(leagueId, -record));
+    if (!positive || !negative || positive->m_count != 1 || negative->m_count != 1) {
+        return StatusType::FAILURE;
+    }
+    return merge_teams(leagueId, positive->m_id_xor, negative->m_id_xor);
+}
+
+// Same as Plains::get_jockey_record, inside league leagueId.
+// Time complexity: O(1) on average.
+output_t<int> LeagueRegistry::get_jockey_record(int leagueId, int jockeyId) {
+    if (leagueId <= 0 || jockeyId <= 0) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    LeagueNode* jockey = m_jockey_map.get_value(league_key(leagueId, jockeyId));
+    if (!jockey) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(jockey->m_record);
+}
+
+// Same as Plains::get_team_record, inside league leagueId.
+// Time complexity: O(1) on average.
+output_t<int> LeagueRegistry::get_team_record(int leagueId, int teamId) {
+    if (leagueId <= 0 || teamId <= 0) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    LeagueNode* team = find_team(leagueId, teamId);
+    if (!team) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(team->m_record);
+}
+
+// Bytes owned by league leagueId: the League itself, every node and record
+// slot, and one shared-map chain node for each of them.
+// Time complexity: O(1) on average.
+output_t<long long> LeagueRegistry::get_league_memory(int leagueId) {
+    if (leagueId <= 0) {
+        return output_t<long long>(StatusType::INVALID_INPUT);
+    }
+    League* league = m_leagues.get_value(leagueId);
+    if (!league) {
+        return output_t<long long>(StatusType::FAILURE);
+    }
+    const long long nodeEntry = sizeof(::Node<HashNode<LeagueNode, long long>>);
+    const long long recordEntry = sizeof(::Node<HashNode<RecordSlot, long long>>);
+    const long long leagueEntry = sizeof(::Node<HashNode<League, int>>);
+    long long nodes = static_cast<long long>(league->m_team_count) + league->m_jockey_count;
+    long long bytes = SlabAllocator<League>::slot_bytes() + leagueEntry
+                    + nodes * (SlabAllocator<LeagueNode>::slot_bytes() + nodeEntry)
+                    + league->m_record_count * (SlabAllocator<RecordSlot>::slot_bytes() + recordEntry);
+    return output_t<long long>(bytes);
+}
+
+int LeagueRegistry::get_league_count() const {
+    return m_leagues.get_size();
+}
+
+// Sets the number of threads used to rehash the shared maps.
+
+// Return value:
+// • ALLOCATION_ERROR in case of a memory allocation/release problem.
+// • INVALID_INPUT if numThreads <= 0.
+// • SUCCESS on success.
+StatusType LeagueRegistry::set_worker_threads(int numThreads) {
+    if (numThreads <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        ThreadPool* pool = numThreads > 1 ? new ThreadPool(numThreads) : nullptr;
+        if (pool && m_numa_node >= 0) {
+            pool->pin_to_node(m_numa_node);
+        }
+        m_leagues.set_thread_pool(pool);
+        m_team_map.set_thread_pool(pool);
+        m_jockey_map.set_thread_pool(pool);
+        m_record_map.set_thread_pool(pool);
+        m_pool.reset(pool);
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+StatusType LeagueRegistry::set_numa_node(int node) {
+    if (node < -1 || node >= Numa::node_count()) {
+        return StatusType::INVALID_INPUT;
+    }
+    m_numa_node = node;
+    m_league_slab.set_numa_node(node);
+    m_node_slab.set_numa_node(node);
+    m_record_slab.set_numa_node(node);
+    m_leagues.set_numa_node(node);
+    m_team_map.set_numa_node(node);
+    m_jockey_map.set_numa_node(node);
+    m_record_map.set_numa_node(node);
+    if (m_pool && node >= 0) {
+        m_pool->pin_to_node(node);
+    }
+    return StatusType::SUCCESS;
+}
+
+void LeagueRegistry::write_placement_report(std::ostream& os) const {
+    NumaPlacement slabs;
+    NumaPlacement maps;
+    m_league_slab.add_placement(slabs);
+    m_node_slab.add_placement(slabs);
+    m_record_slab.add_placement(slabs);
+    m_leagues.add_placement(maps);
+    m_team_map.add_placement(maps);
+    m_jockey_map.add_placement(maps);
+    m_record_map.add_placement(maps);
+    os << "{\"nodes\": " << Numa::node_count()
+       << ", \"preferred_node\": " << m_numa_node
+       << ", \"slabs\": ";
+    slabs.write_json(os);
+    os << ", \"maps\": ";
+    maps.write_json(os);
+    os << "}" << std::endl;
+}
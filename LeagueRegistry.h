@@ -0,0 +1,121 @@
+#ifndef LEAGUE_REGISTRY_H
+#define LEAGUE_REGISTRY_H
+
+#include "wet2util.h"
+#include "HashMap.h"
+#include "SlabAllocator.h"
+#include "ThreadPool.h"
+
+// Many independent leagues in one container.
+// Every league behaves like its own Plains, but all of them share one team
+// map, one jockey map and one record map keyed by (league ID, ID), and one
+// slab allocator per node kind. Creating a league costs one small League
+// object and one map entry, and destroying it releases exactly the nodes
+// and entries it owns, so idle leagues cost bytes instead of bucket arrays.
+class LeagueRegistry {
+private:
+    // Union-find node for a team or a jockey
+    struct LeagueNode {
+        LeagueNode* m_parent;
+        LeagueNode* m_next;     // Next team / jockey node of the same league
+        int m_id;               // ID the node was added with (its map key)
+        int m_team_id;          // Team roots: the current ID of the merged team
+        int m_record;           // Jockeys: own record. Team roots: team record
+        int m_size;             // Team nodes: riders in the subtree
+
+        LeagueNode(int id, LeagueNode* next)
+            : m_parent(this), m_next(next), m_id(id), m_team_id(id), m_record(0), m_size(0) {}
+    };
+
+    // Live teams of one league with a given record: count and XOR of their IDs
+    struct RecordSlot {
+        int m_count;
+        int m_id_xor;
+
+        RecordSlot() : m_count(0), m_id_xor(0) {}
+    };
+
+    struct League {
+        LeagueNode* m_teams;
+        LeagueNode* m_jockeys;
+        int m_team_count;
+        int m_jockey_count;
+        int m_record_count;     // Record slots owned by the league
+
+        League() : m_teams(nullptr), m_jockeys(nullptr), m_team_count(0),
+                   m_jockey_count(0), m_record_count(0) {}
+    };
+
+    typedef HashMap<LeagueNode, long long, FibonacciHash, PowerOfTwoGrowthPolicy<1024>> NodeMap;
+    typedef HashMap<RecordSlot, long long, FibonacciHash, PowerOfTwoGrowthPolicy<1024>> RecordMap;
+    typedef HashMap<League, int, FibonacciHash, PowerOfTwoGrowthPolicy<1024>> LeagueMap;
+
+    LeagueMap m_leagues;
+    NodeMap m_team_map;
+    NodeMap m_jockey_map;
+    RecordMap m_record_map;
+
+    SlabAllocator<League> m_league_slab;
+    SlabAllocator<LeagueNode> m_node_slab;
+    SlabAllocator<RecordSlot> m_record_slab;
+
+    std::unique_ptr<ThreadPool> m_pool;
+    int m_numa_node;
+
+    static long long league_key(int leagueId, int id) {
+        return (static_cast<long long>(leagueId) << 32) | static_cast<unsigned int>(id);
+    }
+
+    // Root of the node's set, compressing the path on the way
+    static LeagueNode* find_root(LeagueNode* node);
+
+    // The root node of a live team with exactly that ID, or nullptr
+    LeagueNode* find_team(int leagueId, int teamId) const;
+
+    // Adds / removes team teamId under record in the league's record map.
+    // record_add may throw std::bad_alloc; record_remove never allocates.
+    void record_add(League* league, int leagueId, int record, int teamId);
+    void record_remove(League* league, int leagueId, int record, int teamId);
+
+public:
+    LeagueRegistry();
+
+    ~LeagueRegistry();
+
+    LeagueRegistry(const LeagueRegistry&) = delete;
+    LeagueRegistry& operator=(const LeagueRegistry&) = delete;
+
+    // Creates an empty league; FAILURE if the league already exists
+    StatusType create_league(int leagueId);
+
+    // Destroys a league with all its teams and jockeys; FAILURE if there is none
+    StatusType destroy_league(int leagueId);
+
+    // The Plains operations, scoped to one league. They return FAILURE for a
+    // league that does not exist and otherwise behave like Plains.
+    StatusType add_team(int leagueId, int teamId);
+    StatusType add_jockey(int leagueId, int jockeyId, int teamId);
+    StatusType update_match(int leagueId, int victoriousJockeyId, int losingJockeyId);
+    StatusType merge_teams(int leagueId, int teamId1, int teamId2);
+    StatusType unite_by_record(int leagueId, int record);
+    output_t<int> get_jockey_record(int leagueId, int jockeyId);
+    output_t<int> get_team_record(int leagueId, int teamId);
+
+    // Bytes owned by the league: its nodes, record slots and map entries
+    output_t<long long> get_league_memory(int leagueId);
+
+    // Number of leagues
+    int get_league_count() const;
+
+    // Sets the number of threads used to rehash the shared maps
+    StatusType set_worker_threads(int numThreads);
+
+    // Places the slabs and the map buckets on the given NUMA node and pins
+    // the worker threads to it; -1 returns to first touch (see Plains)
+    StatusType set_numa_node(int node);
+
+    // Pages per node of the slabs and the map buckets, as one JSON object
+    void write_placement_report(std::ostream& os) const;
+};
+
+#endif // LEAGUE_REGISTRY_H
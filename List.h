@@ -3,6 +3,7 @@
 
 
 #include <cstddef> // For nullptr
+#include <utility>
 
 template<typename T>
 struct Node {
@@ -11,6 +12,8 @@ struct Node {
     Node* next;
 
     Node(const T& value) : data(value), prev(nullptr), next(nullptr) {}
+
+    Node(T&& value) : data(std::move(value)), prev(nullptr), next(nullptr) {}
 };
 
 template<typename T>
@@ -32,30 +35,73 @@ public:
         }
     }
 
+    List(const List&) = delete;
+    List& operator=(const List&) = delete;
+
     void push_back(const T& value) {
-        Node<T>* newNode = new Node<T>(value);
+        link_back(new Node<T>(value));
+    }
+
+    void push_back(T&& value) {
+        link_back(new Node<T>(std::move(value)));
+    }
+
+    void push_front(const T& value) {
+        link_front(new Node<T>(value));
+    }
+
+    void push_front(T&& value) {
+        link_front(new Node<T>(std::move(value)));
+    }
+
+    // Appends a node that belongs to no list; the list takes ownership
+    void link_back(Node<T>* newNode) {
+        newNode->next = nullptr;
+        newNode->prev = tail;
         if (!tail) {
             head = tail = newNode;
         } else {
             tail->next = newNode;
-            newNode->prev = tail;
             tail = newNode;
         }
         m_size++;
     }
 
-    void push_front(const T& value) {
-        Node<T>* newNode = new Node<T>(value);
+    // Prepends a node that belongs to no list; the list takes ownership
+    void link_front(Node<T>* newNode) {
+        newNode->prev = nullptr;
+        newNode->next = head;
         if (!head) {
             head = tail = newNode;
         } else {
             head->prev = newNode;
-            newNode->next = head;
             head = newNode;
         }
         m_size++;
     }
 
+    // Detaches a node of this list without freeing it; the caller owns it
+    Node<T>* unlink(Node<T>* node) {
+        if (node->prev) {
+            node->prev->next = node->next;
+        } else {
+            head = node->next;
+        }
+        if (node->next) {
+            node->next->prev = node->prev;
+        } else {
+            tail = node->prev;
+        }
+        node->prev = node->next = nullptr;
+        m_size--;
+        return node;
+    }
+
+    // Detaches the first node (nullptr if empty); the caller owns it
+    Node<T>* unlink_front() {
+        return head ? unlink(head) : nullptr;
+    }
+
     void pop_back() {
         if (!tail) return;
         Node<T>* toDelete = tail;
@@ -94,20 +140,7 @@ public:
         Node<T>* current = head;
         while (current) {
             if (current->data == value) {
-                if (current->prev) {
-                    current->prev->next = current->next;
-                } else {
-                    head = current->next;
-                }
-
-                if (current->next) {
-                    current->next->prev = current->prev;
-                } else {
-                    tail = current->prev;
-                }
-
-                delete current;
-                m_size--;
+                delete unlink(current);
                 return;
             }
             current = current->next;
@@ -126,6 +159,15 @@ public:
             return current->data;
         }
 
+        T* operator->() const {
+            return &current->data;
+        }
+
+        // The list node the iterator points at
+        Node<T>* node() const {
+            return current;
+        }
+
         Iterator& operator++() { // Pre-increment
             if (current) current = current->next;
             return *this;
@@ -142,6 +184,11 @@ public:
         }
     };
 
+    // First node, or nullptr; lets callers prefetch a chain
+    const Node<T>* first() const {
+        return head;
+    }
+
     Iterator begin() const {
         return Iterator(head);
     }
@@ -0,0 +1,337 @@
+#ifndef MATCH_SKETCHES_H
+#define MATCH_SKETCHES_H
+
+#include <cmath>
+#include <cstdint>
+
+#include "SimdProbe.h"
+
+// Fixed-size summaries of a stream of IDs (all > 0). Each one can absorb
+// another of the same kind, so summaries built by different shards (several
+// Plains, or the leagues of a registry) combine into one for the whole
+// stream.
+
+// 64-bit mix of an ID (splitmix64 finalizer), seeded per use
+inline uint64_t sketch_hash(int id, uint64_t seed) {
+    uint64_t x = static_cast<uint64_t>(static_cast<uint32_t>(id)) + seed * 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// HyperLogLog distinct counter with 2^PRECISION one-byte registers (4 KB).
+// The standard error of the estimate is 1.04 / sqrt(2^PRECISION), 1.6%.
+class HyperLogLog {
+public:
+    static constexpr int PRECISION = 12;
+    static constexpr int REGISTERS = 1 << PRECISION;
+
+private:
+    uint8_t m_registers[REGISTERS];
+
+public:
+    HyperLogLog() {
+        clear();
+    }
+
+    void clear() {
+        for (int i = 0; i < REGISTERS; ++i) {
+            m_registers[i] = 0;
+        }
+    }
+
+    void add(int id) {
+        uint64_t hash = sketch_hash(id, 1);
+        int index = static_cast<int>(hash >> (64 - PRECISION));
+        // Position of the first set bit among the remaining ones
+        uint64_t rest = hash << PRECISION;
+        uint8_t rank = rest ? static_cast<uint8_t>(__builtin_clzll(rest) + 1)
+                            : static_cast<uint8_t>(64 - PRECISION + 1);
+        if (rank > m_registers[index]) {
+            m_registers[index] = rank;
+        }
+    }
+
+    void merge(const HyperLogLog& other) {
+        for (int i = 0; i < REGISTERS; ++i) {
+            if (other.m_registers[i] > m_registers[i]) {
+                m_registers[i] = other.m_registers[i];
+            }
+        }
+    }
+
+    // Estimated number of distinct IDs added; linear counting while many
+    // registers are still empty
+    long long estimate() const {
+        double sum = 0;
+        int zeros = 0;
+        for (int i = 0; i < REGISTERS; ++i) {
+            sum += std::ldexp(1.0, -m_registers[i]);
+            zeros += m_registers[i] == 0;
+        }
+        const double m = REGISTERS;
+        double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * std::log(m / zeros);
+        }
+        return static_cast<long long>(estimate + 0.5);
+    }
+};
+
+// Count-Min sketch: DEPTH rows of WIDTH counters (16 KB). An estimate never
+// undercounts, and overcounts by more than 2N / WIDTH (N: the total of all
+// counts) with probability at most 2^-DEPTH. Updates are conservative: only
+// the counters that would otherwise fall below the new estimate are raised,
+// which keeps the overcount of rare IDs far under that bound. Sums of such
+// sketches are still upper bounds, so merging stays a plain addition.
+class CountMinSketch {
+public:
+    static constexpr int DEPTH = 4;
+    static constexpr int WIDTH = 1024;
+
+private:
+    uint32_t m_counters[DEPTH][WIDTH];
+
+    // Row r uses 10 bits of one 64-bit hash each
+    static int column(uint64_t hash, int row) {
+        return static_cast<int>((hash >> (row * 16)) & (WIDTH - 1));
+    }
+
+public:
+    CountMinSketch() {
+        clear();
+    }
+
+    void clear() {
+        for (int row = 0; row < DEPTH; ++row) {
+            for (int i = 0; i < WIDTH; ++i) {
+                m_counters[row][i] = 0;
+            }
+        }
+    }
+
+    // Returns the new estimate of id
+    uint32_t add(int id, uint32_t count = 1) {
+        uint32_t target = estimate(id) + count;
+        uint64_t hash = sketch_hash(id, 2);
+        for (int row = 0; row < DEPTH; ++row) {
+            uint32_t& counter = m_counters[row][column(hash, row)];
+            counter = counter < target ? target : counter;
+        }
+        return target;
+    }
+
+    uint32_t estimate(int id) const {
+        uint64_t hash = sketch_hash(id, 2);
+        uint32_t count = m_counters[0][column(hash, 0)];
+        for (int row = 1; row < DEPTH; ++row) {
+            uint32_t value = m_counters[row][column(hash, row)];
+            count = value < count ? value : count;
+        }
+        return count;
+    }
+
+    void merge(const CountMinSketch& other) {
+        for (int row = 0; row < DEPTH; ++row) {
+            for (int i = 0; i < WIDTH; ++i) {
+                m_counters[row][i] += other.m_counters[row][i];
+            }
+        }
+    }
+};
+
+// Heavy hitters: a Count-Min sketch of every ID plus a Space-Saving style
+// list of the CAPACITY IDs with the largest estimates. An ID outside the
+// list replaces the smallest entry once its estimate exceeds it, so a
+// replacement scan is only paid by IDs on their way up, and the long tail
+// of rare IDs costs one sketch update and one probe of the list (a probe
+// group at a time, SimdProbe.h). Counts are Count-Min estimates: never
+// below the true count. Merging adds the sketches and reranks the union of
+// both lists by the merged estimates.
+class HeavyHitters {
+public:
+    static constexpr int CAPACITY = 4 * PROBE_GROUP_SIZE;
+
+private:
+    CountMinSketch m_sketch;
+    int m_ids[CAPACITY];            // 0: free entry; entries fill up in order
+    uint32_t m_counts[CAPACITY];    // Estimate of every listed ID
+    int m_size;
+    int m_min_entry;                // Entry with the smallest count, once full
+
+    int find(int id) const {
+        for (int group = 0; group < CAPACITY; group += PROBE_GROUP_SIZE) {
+            unsigned int mask = match_group(m_ids + group, id, 0).m_key_mask;
+            if (mask) {
+                return group + __builtin_ctz(mask);
+            }
+        }
+        return -1;
+    }
+
+    void find_min() {
+        m_min_entry = 0;
+        for (int i = 1; i < m_size; ++i) {
+            m_min_entry = m_counts[i] < m_counts[m_min_entry] ? i : m_min_entry;
+        }
+    }
+
+    // Lists id with the given estimate if it ranks among the largest
+    void offer(int id, uint32_t estimate) {
+        int entry = find(id);
+        if (entry >= 0) {
+            m_counts[entry] = estimate;
+            if (entry == m_min_entry && m_size == CAPACITY) {
+                find_min();
+            }
+        } else if (m_size < CAPACITY) {
+            m_ids[m_size] = id;
+            m_counts[m_size] = estimate;
+            if (++m_size == CAPACITY) {
+                find_min();
+            }
+        } else if (estimate > m_counts[m_min_entry]) {
+            m_ids[m_min_entry] = id;
+            m_counts[m_min_entry] = estimate;
+            find_min();
+        }
+    }
+
+public:
+    HeavyHitters() {
+        clear();
+    }
+
+    void clear() {
+        m_sketch.clear();
+        for (int i = 0; i < CAPACITY; ++i) {
+            m_ids[i] = 0;
+            m_counts[i] = 0;
+        }
+        m_size = 0;
+        m_min_entry = 0;
+    }
+
+    void add(int id) {
+        offer(id, m_sketch.add(id));
+    }
+
+    uint32_t estimate(int id) const {
+        return m_sketch.estimate(id);
+    }
+
+    void merge(const HeavyHitters& other) {
+        int ids[2 * CAPACITY];
+        int size = 0;
+        for (int i = 0; i < m_size; ++i) {
+            ids[size++] = m_ids[i];
+        }
+        for (int i = 0; i < other.m_size; ++i) {
+            if (find(other.m_ids[i]) < 0) {
+                ids[size++] = other.m_ids[i];
+            }
+        }
+        m_sketch.merge(other.m_sketch);
+        for (int i = 0; i < CAPACITY; ++i) {
+            m_ids[i] = 0;
+        }
+        m_size = 0;
+        for (int i = 0; i < size; ++i) {
+            offer(ids[i], m_sketch.estimate(ids[i]));
+        }
+    }
+
+    // Writes up to capacity listed IDs, largest count first, with their
+    // counts; returns how many were written
+    int top(int* ids, long long* counts, int capacity) const {
+        int order[CAPACITY];
+        for (int i = 0; i < m_size; ++i) {
+            order[i] = i;
+        }
+        int written = 0;
+        for (; written < capacity && written < m_size; ++written) {
+            int best = written;
+            for (int i = written + 1; i < m_size; ++i) {
+                if (m_counts[order[i]] > m_counts[order[best]]) {
+                    best = i;
+                }
+            }
+            int entry = order[best];
+            order[best] = order[written];
+            order[written] = entry;
+            ids[written] = m_ids[entry];
+            counts[written] = m_counts[entry];
+        }
+        return written;
+    }
+};
+
+// The sketches Plains keeps over its update_match stream (about 40 KB):
+// - distinct riders that played, per window of matches (the current window
+//   and the last complete one)
+// - wins per rider, and the riders with the most wins
+// - matches per team (by its ID at match time), and the most active teams
+class MatchSketches {
+private:
+    HyperLogLog m_active[2];        // Current and previous window
+    int m_current;
+    long long m_window;             // Matches per window (0: one endless window)
+    long long m_window_matches;     // Matches in the current window
+    HeavyHitters m_winners;
+    HeavyHitters m_teams;
+
+public:
+    MatchSketches() : m_current(0), m_window(0), m_window_matches(0) {}
+
+    MatchSketches(const MatchSketches&) = delete;
+    MatchSketches& operator=(const MatchSketches&) = delete;
+
+    // Starts a new window every matches matches (0: never); the current
+    // window starts over
+    void set_window(long long matches) {
+        m_window = matches;
+        m_window_matches = 0;
+        m_active[m_current].clear();
+    }
+
+    void record_match(int winner, int loser, int winningTeam, int losingTeam) {
+        if (m_window > 0 && m_window_matches == m_window) {
+            m_current ^= 1;
+            m_active[m_current].clear();
+            m_window_matches = 0;
+        }
+        m_window_matches++;
+        m_active[m_current].add(winner);
+        m_active[m_current].add(loser);
+        m_winners.add(winner);
+        m_teams.add(winningTeam);
+        m_teams.add(losingTeam);
+    }
+
+    // Combines the sketches of another shard into these. Windows are merged
+    // as they are, so the shards should share the window length.
+    void merge(const MatchSketches& other) {
+        m_active[m_current].merge(other.m_active[other.m_current]);
+        m_active[m_current ^ 1].merge(other.m_active[other.m_current ^ 1]);
+        m_winners.merge(other.m_winners);
+        m_teams.merge(other.m_teams);
+    }
+
+    long long active_jockeys(bool previousWindow) const {
+        return m_active[previousWindow ? m_current ^ 1 : m_current].estimate();
+    }
+
+    long long jockey_wins(int jockeyId) const {
+        return m_winners.estimate(jockeyId);
+    }
+
+    int top_winners(int* jockeyIds, long long* wins, int capacity) const {
+        return m_winners.top(jockeyIds, wins, capacity);
+    }
+
+    int top_teams(int* teamIds, long long* matches, int capacity) const {
+        return m_teams.top(teamIds, matches, capacity);
+    }
+};
+
+#endif // MATCH_SKETCHES_H
@@ -0,0 +1,181 @@
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <utility>
+
+#include "Numa.h"
+
+// Chunked arena that owns every node of a given type.
+// Nodes are constructed in place and released all at once when the arena is
+// destroyed. A node nothing refers to any more can be recycled: it is reset
+// to a default node and handed out again by the next create.
+template<typename T>
+class NodeArena {
+private:
+    struct Chunk {
+        T* m_items;
+        int m_used;
+        int m_capacity;
+        Chunk* m_next;
+    };
+
+    Chunk* m_head;      // Chunk currently used for single allocations
+    Chunk* m_blocks;    // Chunks handed out whole by allocate_block
+    int m_chunk_size;
+    int m_count;
+    int m_numa_node;    // Preferred node of the chunks, -1 for first touch
+    T** m_recycled;     // Recycled nodes, reused before new chunk space
+    int m_recycled_count;
+    int m_recycled_capacity;
+
+    static constexpr int DEFAULT_CHUNK_SIZE = 1024;
+
+    Chunk* new_chunk(int capacity) {
+        T* items = static_cast<T*>(::operator new(sizeof(T) * static_cast<std::size_t>(capacity)));
+        if (m_numa_node >= 0) {
+            // Before the nodes are constructed, so no page has to move
+            Numa::bind(items, sizeof(T) * static_cast<std::size_t>(capacity), m_numa_node);
+        }
+        Chunk* chunk = new (std::nothrow) Chunk;
+        if (!chunk) {
+            ::operator delete(items);
+            throw std::bad_alloc();
+        }
+        chunk->m_items = items;
+        chunk->m_used = 0;
+        chunk->m_capacity = capacity;
+        chunk->m_next = nullptr;
+        return chunk;
+    }
+
+    static void release_chain(Chunk* chunk) {
+        while (chunk) {
+            Chunk* next = chunk->m_next;
+            for (int i = 0; i < chunk->m_used; ++i) {
+                chunk->m_items[i].~T();
+            }
+            ::operator delete(chunk->m_items);
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+public:
+    explicit NodeArena(int chunkSize = DEFAULT_CHUNK_SIZE)
+        : m_head(nullptr), m_blocks(nullptr), m_chunk_size(chunkSize), m_count(0), m_numa_node(-1),
+          m_recycled(nullptr), m_recycled_count(0), m_recycled_capacity(0) {}
+
+    ~NodeArena() {
+        release_chain(m_head);
+        release_chain(m_blocks);
+        delete[] m_recycled;
+    }
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    // Construct a single node in the arena
+    // (a recycled node is reconstructed in place, so T's constructor must
+    // not throw)
+    template<typename... Args>
+    T* create(Args&&... args) {
+        if (m_recycled_count > 0) {
+            T* item = m_recycled[--m_recycled_count];
+            item->~T();
+            new (item) T(std::forward<Args>(args)...);
+            m_count++;
+            return item;
+        }
+        if (!m_head || m_head->m_used == m_head->m_capacity) {
+            Chunk* chunk = new_chunk(m_chunk_size);
+            chunk->m_next = m_head;
+            m_head = chunk;
+        }
+        T* item = new (m_head->m_items + m_head->m_used) T(std::forward<Args>(args)...);
+        m_head->m_used++;
+        m_count++;
+        return item;
+    }
+
+    // Construct count default nodes laid out contiguously in memory
+    T* allocate_block(int count) {
+        if (count <= 0) {
+            return nullptr;
+        }
+        Chunk* chunk = new_chunk(count);
+        chunk->m_next = m_blocks;
+        m_blocks = chunk;
+        for (int i = 0; i < count; ++i) {
+            new (chunk->m_items + i) T();
+            chunk->m_used++;
+        }
+        m_count += count;
+        return chunk->m_items;
+    }
+
+    // Makes room for count more recycle calls without allocating
+    void reserve_recycled(int count) {
+        if (m_recycled_count + count <= m_recycled_capacity) {
+            return;
+        }
+        int capacity = m_recycled_capacity ? 2 * m_recycled_capacity : 64;
+        capacity = capacity < m_recycled_count + count ? m_recycled_count + count : capacity;
+        T** recycled = new T*[capacity];
+        for (int i = 0; i < m_recycled_count; ++i) {
+            recycled[i] = m_recycled[i];
+        }
+        delete[] m_recycled;
+        m_recycled = recycled;
+        m_recycled_capacity = capacity;
+    }
+
+    // Resets item, which nothing may refer to any more, and keeps it for the
+    // next create. reserve_recycled must have made room.
+    void recycle(T* item) {
+        item->~T();
+        new (item) T();
+        m_recycled[m_recycled_count++] = item;
+        m_count--;
+    }
+
+    // Prefers the given node for all chunks, moving the existing ones
+    // (-1: first touch again for new chunks)
+    void set_numa_node(int node) {
+        m_numa_node = node;
+        for (Chunk* chain : {m_head, m_blocks}) {
+            for (Chunk* chunk = chain; chunk && node >= 0; chunk = chunk->m_next) {
+                Numa::bind(chunk->m_items, sizeof(T) * static_cast<std::size_t>(chunk->m_capacity), node);
+            }
+        }
+    }
+
+    // Adds the pages of every chunk to the placement report
+    void add_placement(NumaPlacement& placement) const {
+        for (Chunk* chain : {m_head, m_blocks}) {
+            for (Chunk* chunk = chain; chunk; chunk = chunk->m_next) {
+                placement.add_range(chunk->m_items, sizeof(T) * static_cast<std::size_t>(chunk->m_capacity));
+            }
+        }
+    }
+
+    // Exchange all nodes with another arena (the node preferences stay)
+    void swap(NodeArena& other) {
+        std::swap(m_head, other.m_head);
+        std::swap(m_blocks, other.m_blocks);
+        std::swap(m_chunk_size, other.m_chunk_size);
+        std::swap(m_count, other.m_count);
+        std::swap(m_recycled, other.m_recycled);
+        std::swap(m_recycled_count, other.m_recycled_count);
+        std::swap(m_recycled_capacity, other.m_recycled_capacity);
+    }
+
+    // Number of nodes currently owned by the arena
+    int get_size() const {
+        return m_count;
+    }
+};
+
+#endif // NODE_ARENA_H
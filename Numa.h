@@ -0,0 +1,234 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <ostream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// NUMA placement through raw Linux system calls (mbind, get_mempolicy,
+// getcpu, sched_setaffinity) and sysfs, without libnuma. On single-node
+// machines, non-Linux systems or when a call is refused (containers often
+// filter mbind), every operation degrades to a no-op that reports failure,
+// and callers simply keep the default first-touch placement.
+class Numa {
+public:
+    static constexpr int MAX_NODES = 64;
+
+    // Nodes the kernel reports online (1 if unknown)
+    static int node_count();
+
+    // Node of the CPU the calling thread runs on (0 if unknown)
+    static int current_node();
+
+    // Prefers node for the pages of [address, address + bytes), moving the
+    // ones already touched. Partial pages at both ends are included.
+    // False if nothing was done (single node, invalid node or refused call).
+    static bool bind(const void* address, std::size_t bytes, int node);
+
+    // Node holding the page of address, or -1 if unknown
+    static int node_of(const void* address);
+
+    // Restricts thread to the CPUs of node; false if that was not possible
+    static bool pin_thread(pthread_t thread, int node);
+};
+
+// Pages per node over a set of memory ranges, for placement reports.
+// Large ranges are sampled at MAX_SAMPLES evenly spaced pages.
+class NumaPlacement {
+private:
+    static constexpr int MAX_SAMPLES = 4096;
+
+    long long m_pages[Numa::MAX_NODES];
+    long long m_unknown;
+    long long m_bytes;
+
+public:
+    NumaPlacement();
+
+    void add_range(const void* address, std::size_t bytes);
+
+    long long get_pages(int node) const { return m_pages[node]; }
+    long long get_unknown() const { return m_unknown; }
+
+    // {"bytes": ..., "pages": {"0": ..., ...}, "unknown": ...} over the
+    // nodes that hold any sampled page
+    void write_json(std::ostream& os) const;
+};
+
+// ---------------------------------------------------------------- Implementation
+
+// Constants of <linux/mempolicy.h>, which is not always installed
+static const int NUMA_MPOL_PREFERRED = 1;
+static const unsigned int NUMA_MPOL_MF_MOVE = 1u << 1;
+static const unsigned long NUMA_MPOL_F_NODE = 1ul << 0;
+static const unsigned long NUMA_MPOL_F_ADDR = 1ul << 1;
+
+// Reads a small sysfs file into buffer as a C string; false if it is missing
+inline bool numa_read_sysfs(const char* path, char* buffer, int size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    ssize_t length = read(fd, buffer, size - 1);
+    close(fd);
+    if (length <= 0) {
+        return false;
+    }
+    buffer[length] = '\0';
+    return true;
+}
+
+// Calls visit(first, last) for every range of a sysfs list like "0-3,8,10-11"
+template<typename Visitor>
+inline void numa_parse_list(const char* text, Visitor visit) {
+    while (*text >= '0' && *text <= '9') {
+        int first = 0;
+        while (*text >= '0' && *text <= '9') {
+            first = first * 10 + (*text++ - '0');
+        }
+        int last = first;
+        if (*text == '-') {
+            text++;
+            last = 0;
+            while (*text >= '0' && *text <= '9') {
+                last = last * 10 + (*text++ - '0');
+            }
+        }
+        visit(first, last);
+        if (*text == ',') {
+            text++;
+        }
+    }
+}
+
+inline std::size_t numa_page_size() {
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? static_cast<std::size_t>(size) : 4096;
+}
+
+inline int numa_online_nodes() {
+    char buffer[256];
+    int nodes = 1;
+    if (numa_read_sysfs("/sys/devices/system/node/online", buffer, sizeof(buffer))) {
+        numa_parse_list(buffer, [&](int, int last) {
+            nodes = last + 1 > nodes ? last + 1 : nodes;
+        });
+    }
+    return nodes < Numa::MAX_NODES ? nodes : Numa::MAX_NODES;
+}
+
+inline int Numa::node_count() {
+    static const int count = numa_online_nodes();
+    return count;
+}
+
+inline int Numa::current_node() {
+#ifdef SYS_getcpu
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 && node < static_cast<unsigned int>(MAX_NODES)) {
+        return static_cast<int>(node);
+    }
+#endif
+    return 0;
+}
+
+inline bool Numa::bind(const void* address, std::size_t bytes, int node) {
+#ifdef SYS_mbind
+    if (node < 0 || node >= node_count() || node_count() < 2 || bytes == 0) {
+        return false;
+    }
+    std::size_t page = numa_page_size();
+    uintptr_t begin = reinterpret_cast<uintptr_t>(address) & ~(page - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(address) + bytes + page - 1) & ~(page - 1);
+    unsigned long mask = 1ul << node;
+    return syscall(SYS_mbind, begin, end - begin, NUMA_MPOL_PREFERRED, &mask,
+                   static_cast<unsigned long>(MAX_NODES + 1), NUMA_MPOL_MF_MOVE) == 0;
+#else
+    (void)address;
+    (void)bytes;
+    (void)node;
+    return false;
+#endif
+}
+
+inline int Numa::node_of(const void* address) {
+#ifdef SYS_get_mempolicy
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0ul, address,
+                NUMA_MPOL_F_NODE | NUMA_MPOL_F_ADDR) == 0) {
+        return node;
+    }
+#else
+    (void)address;
+#endif
+    return -1;
+}
+
+inline bool Numa::pin_thread(pthread_t thread, int node) {
+    if (node < 0 || node >= node_count()) {
+        return false;
+    }
+    char path[64];
+    char buffer[1024];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    if (!numa_read_sysfs(path, buffer, sizeof(buffer))) {
+        return false;
+    }
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    bool any = false;
+    numa_parse_list(buffer, [&](int first, int last) {
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+            CPU_SET(cpu, &cpus);
+            any = true;
+        }
+    });
+    return any && pthread_setaffinity_np(thread, sizeof(cpus), &cpus) == 0;
+}
+
+inline NumaPlacement::NumaPlacement() : m_unknown(0), m_bytes(0) {
+    for (int node = 0; node < Numa::MAX_NODES; ++node) {
+        m_pages[node] = 0;
+    }
+}
+
+inline void NumaPlacement::add_range(const void* address, std::size_t bytes) {
+    if (!address || bytes == 0) {
+        return;
+    }
+    m_bytes += static_cast<long long>(bytes);
+    std::size_t page = numa_page_size();
+    uintptr_t begin = reinterpret_cast<uintptr_t>(address) & ~(page - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(address) + bytes;
+    std::size_t pages = (end - begin + page - 1) / page;
+    std::size_t stride = pages > static_cast<std::size_t>(MAX_SAMPLES) ? pages / MAX_SAMPLES : 1;
+    for (std::size_t i = 0; i < pages; i += stride) {
+        int node = Numa::node_of(reinterpret_cast<const void*>(begin + i * page));
+        if (node >= 0 && node < Numa::MAX_NODES) {
+            m_pages[node]++;
+        } else {
+            m_unknown++;
+        }
+    }
+}
+
+inline void NumaPlacement::write_json(std::ostream& os) const {
+    os << "{\"bytes\": " << m_bytes << ", \"pages\": {";
+    bool first = true;
+    for (int node = 0; node < Numa::MAX_NODES; ++node) {
+        if (m_pages[node]) {
+            os << (first ? "" : ", ") << "\"" << node << "\": " << m_pages[node];
+            first = false;
+        }
+    }
+    os << "}, \"unknown\": " << m_unknown << "}";
+}
+
+#endif // NUMA_H
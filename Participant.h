@@ -3,9 +3,6 @@
 
 #include <memory>
 
-template <typename Jockey, typename Team>
-class UnionFind;
-
 class Participant {
 protected:
 public:
@@ -26,19 +23,23 @@ public:
     bool operator==(const Participant& other) const {
         return m_id == other.m_id;
     }
-
-    template <typename Jockey, typename Team>
-    friend class UnionFind;
 };
 
 class Jockey : public Participant {
 public:
-    Jockey(int id) : Participant(id) {}
+    Jockey(int id = 0) : Participant(id) {}
 };
 
 class Team : public Participant {
 public:
-    Team(int id) : Participant(id) {}
+    int m_indexed_record;   // Record the team is listed under in the record index
+    bool m_indexed;         // Listed in the record index at all
+    bool m_dirty;           // Queued for record index reconciliation
+    bool m_retired;         // Absorbed by a merge; its ID is gone for good
+    int m_column_row;       // Row of the live team in the team columns
+
+    Team(int id = 0) : Participant(id), m_indexed_record(0), m_indexed(false), m_dirty(false),
+                       m_retired(false), m_column_row(-1) {}
 };
 
 #endif //PARTICIPANT_H
@@ -0,0 +1,57 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+// LSD radix sort of (key, row) pairs by key.
+// The sort is stable, so rows sharing a key stay in their input order.
+// keys/rows hold the input and receive the sorted output; tmpKeys/tmpRows
+// must have room for count elements and are used as scratch space.
+// Time complexity: O(count).
+inline void radix_sort_pairs(unsigned int* keys, int* rows, int count,
+                             unsigned int* tmpKeys, int* tmpRows)
+{
+    const int RADIX_BITS = 11;
+    const int BUCKETS = 1 << RADIX_BITS;
+    const unsigned int MASK = BUCKETS - 1;
+
+    int histogram[BUCKETS];
+    unsigned int* srcKeys = keys;
+    int* srcRows = rows;
+    unsigned int* dstKeys = tmpKeys;
+    int* dstRows = tmpRows;
+
+    for (int shift = 0; shift < 32; shift += RADIX_BITS) {
+        for (int b = 0; b < BUCKETS; ++b) {
+            histogram[b] = 0;
+        }
+        for (int i = 0; i < count; ++i) {
+            histogram[(srcKeys[i] >> shift) & MASK]++;
+        }
+        int offset = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            int bucketSize = histogram[b];
+            histogram[b] = offset;
+            offset += bucketSize;
+        }
+        for (int i = 0; i < count; ++i) {
+            int position = histogram[(srcKeys[i] >> shift) & MASK]++;
+            dstKeys[position] = srcKeys[i];
+            dstRows[position] = srcRows[i];
+        }
+        unsigned int* swapKeys = srcKeys;
+        srcKeys = dstKeys;
+        dstKeys = swapKeys;
+        int* swapRows = srcRows;
+        srcRows = dstRows;
+        dstRows = swapRows;
+    }
+
+    // Three passes leave the result in the scratch arrays; copy it back
+    if (srcKeys != keys) {
+        for (int i = 0; i < count; ++i) {
+            keys[i] = srcKeys[i];
+            rows[i] = srcRows[i];
+        }
+    }
+}
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,340 @@
+#ifndef RECORD_HISTORY_H
+#define RECORD_HISTORY_H
+
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#include "FlatTable.h"
+
+// Record changes of teams and riders by match sequence number (the number of
+// successful matches played so far), for point-in-time queries over a
+// bounded window of recent matches.
+//
+// Every subject (a team or rider ID) has a stream of (sequence, delta)
+// entries in 64-byte blocks from a shared pool. A block stores the record
+// before its first entry, so a query only decodes the one block that covers
+// the sequence, found by binary search over the subject's blocks. Entries
+// are varints of the sequence delta with a 2-bit tag for the common deltas
+// of +1 and -1 (other deltas, from merges, follow as a zigzag varint), so a
+// match costs about one byte per subject.
+//
+// Blocks whose entries all fall before the window are released: on the next
+// append to their subject, and by a sweep that visits SWEEP_SLOTS subjects
+// per match. A stream the sweep leaves without blocks is freed with its
+// ring, and prepare() shrinks a stream table once it is mostly empty, so
+// memory follows the subjects that changed within the window plus one sweep
+// of the subjects. A subject without a stream or blocks has not changed
+// within the window, so its current record is the answer.
+class RecordHistory {
+public:
+    enum Kind {
+        TEAM = 0,
+        JOCKEY = 1
+    };
+
+private:
+    static constexpr int BLOCK_BYTES = 48;
+    static constexpr int MAX_ENTRY_BYTES = 15;     // 10-byte varint + 5-byte delta
+    static constexpr int SWEEP_SLOTS = 4;
+
+    struct Block {
+        int m_first_seq;
+        int m_last_seq;
+        int m_base;             // Record before the first entry
+        int m_used;             // Bytes used; next free block while released
+        uint8_t m_bytes[BLOCK_BYTES];
+    };
+
+    // A subject's blocks, oldest first, in a ring of block indices. The
+    // newest block and the end of the oldest one are copied here, so that
+    // appends and sweeps usually touch no other memory than the stream and
+    // the newest block.
+    struct Stream {
+        int m_id;
+        int m_head;
+        int m_count;
+        int m_capacity;         // Power of two, or 0
+        int m_tail;             // Newest block
+        int m_oldest_last;      // Last sequence of the oldest block
+        bool m_pinned;          // Prepared for an append, so never freed
+        int* m_ring;
+
+        int block(int i) const {
+            return m_ring[(m_head + i) & (m_capacity - 1)];
+        }
+    };
+
+    FlatTable<Stream> m_streams[2];
+    int m_sweep_cursor[2];
+
+    std::unique_ptr<Block[]> m_blocks;
+    int m_block_count;          // Blocks ever taken from the pool
+    int m_block_capacity;
+    int m_free_block;           // Head of the released blocks, or -1
+    int m_free_count;
+    int m_live_blocks;
+
+    int m_retention;            // Matches kept
+    int m_window_start;         // Oldest sequence that can still be answered
+
+    static void put_varint(uint8_t* bytes, int& used, uint64_t value) {
+        while (value >= 0x80) {
+            bytes[used++] = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        bytes[used++] = static_cast<uint8_t>(value);
+    }
+
+    static uint64_t get_varint(const uint8_t* bytes, int& offset) {
+        uint64_t value = 0;
+        int shift = 0;
+        while (bytes[offset] & 0x80) {
+            value |= static_cast<uint64_t>(bytes[offset++] & 0x7F) << shift;
+            shift += 7;
+        }
+        return value | (static_cast<uint64_t>(bytes[offset++]) << shift);
+    }
+
+    static uint64_t zigzag(int value) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(value)) << 1) ^
+               static_cast<uint64_t>(static_cast<int64_t>(value) >> 63);
+    }
+
+    static int unzigzag(uint64_t value) {
+        return static_cast<int>(static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1));
+    }
+
+    // Record after the block's entries up to and including sequence
+    int decode(const Block& block, int sequence) const {
+        int value = block.m_base;
+        int seq = block.m_first_seq;
+        int offset = 0;
+        while (offset < block.m_used) {
+            uint64_t word = get_varint(block.m_bytes, offset);
+            seq += static_cast<int>(word >> 2);
+            if (seq > sequence) {
+                break;
+            }
+            int tag = static_cast<int>(word & 3);
+            value += tag == 0 ? 1 : tag == 1 ? -1 : unzigzag(get_varint(block.m_bytes, offset));
+        }
+        return value;
+    }
+
+    void release_block(int index) {
+        m_blocks[index].m_used = m_free_block;
+        m_free_block = index;
+        m_free_count++;
+        m_live_blocks--;
+    }
+
+    int take_block() {
+        int index = m_free_block;
+        if (index >= 0) {
+            m_free_block = m_blocks[index].m_used;
+            m_free_count--;
+        } else {
+            index = m_block_count++;
+        }
+        m_live_blocks++;
+        return index;
+    }
+
+    // Releases the stream's blocks that end before the window
+    void expire(Stream& stream) {
+        while (stream.m_count > 0 && stream.m_oldest_last < m_window_start) {
+            release_block(stream.block(0));
+            stream.m_head = (stream.m_head + 1) & (stream.m_capacity - 1);
+            if (--stream.m_count > 0) {
+                stream.m_oldest_last = m_blocks[stream.block(0)].m_last_seq;
+            }
+        }
+    }
+
+    void grow_ring(Stream& stream) {
+        int capacity = stream.m_capacity ? 2 * stream.m_capacity : 2;
+        int* ring = new int[capacity];
+        for (int i = 0; i < stream.m_count; ++i) {
+            ring[i] = stream.block(i);
+        }
+        delete[] stream.m_ring;
+        stream.m_ring = ring;
+        stream.m_head = 0;
+        stream.m_capacity = capacity;
+    }
+
+    void sweep(Kind kind) {
+        FlatTable<Stream>& streams = m_streams[kind];
+        int capacity = streams.get_capacity();
+        for (int i = 0; i < SWEEP_SLOTS && capacity > 0; ++i) {
+            int& cursor = m_sweep_cursor[kind];
+            cursor = cursor + 1 < capacity ? cursor + 1 : 0;
+            Stream* stream = streams.slot(cursor);
+            if (!stream) {
+                continue;
+            }
+            expire(*stream);
+            if (stream->m_count == 0 && !stream->m_pinned) {
+                delete[] stream->m_ring;
+                streams.remove(stream);
+            }
+        }
+    }
+
+public:
+    // History from sequence start on, keeping retention matches
+    RecordHistory(int retention, int start)
+        : m_sweep_cursor{0, 0}, m_blocks(), m_block_count(0), m_block_capacity(0), m_free_block(-1),
+          m_free_count(0), m_live_blocks(0), m_retention(retention), m_window_start(start) {}
+
+    ~RecordHistory() {
+        for (int kind = 0; kind < 2; ++kind) {
+            for (int i = 0; i < m_streams[kind].get_capacity(); ++i) {
+                Stream* stream = m_streams[kind].slot(i);
+                if (stream) {
+                    delete[] stream->m_ring;
+                }
+            }
+        }
+    }
+
+    RecordHistory(const RecordHistory&) = delete;
+    RecordHistory& operator=(const RecordHistory&) = delete;
+
+    // Shrinking the window releases the older blocks as they are swept;
+    // growing it cannot bring back what was released
+    void set_retention(int retention) {
+        m_retention = retention;
+    }
+
+    int get_window_start() const { return m_window_start; }
+
+    // Makes sure the next append for this subject cannot fail, and keeps
+    // the sweep from freeing its stream until then. Call it for every
+    // subject of a change before changing anything; it may throw
+    // std::bad_alloc, leaving at most an empty unpinned stream behind. If
+    // the change fails after all, unpin() the subjects prepared for it.
+    void prepare(Kind kind, int id) {
+        FlatTable<Stream>& streams = m_streams[kind];
+        streams.shrink();
+        Stream* stream = streams.find(id);
+        if (!stream) {
+            stream = streams.insert(id);
+            stream->m_head = 0;
+            stream->m_count = 0;
+            stream->m_capacity = 0;
+            stream->m_tail = -1;
+            stream->m_oldest_last = 0;
+            stream->m_ring = nullptr;
+            stream->m_pinned = false;
+        }
+        if (stream->m_count == stream->m_capacity) {
+            grow_ring(*stream);
+        }
+        if (stream->m_count > 0) {
+            __builtin_prefetch(&m_blocks[stream->m_tail], 1);
+        }
+        // Enough free blocks for the four subjects of a match
+        if (m_free_count + (m_block_capacity - m_block_count) < 4) {
+            int capacity = m_block_capacity ? 2 * m_block_capacity : 64;
+            std::unique_ptr<Block[]> blocks(new Block[capacity]);
+            for (int i = 0; i < m_block_count; ++i) {
+                blocks[i] = m_blocks[i];
+            }
+            m_blocks = std::move(blocks);
+            m_block_capacity = capacity;
+        }
+        stream->m_pinned = true;
+    }
+
+    // Lets the sweep free the subject's stream again after a prepare whose
+    // change was abandoned (nothing to do if it has no stream)
+    void unpin(Kind kind, int id) {
+        Stream* stream = m_streams[kind].find(id);
+        if (stream) {
+            stream->m_pinned = false;
+        }
+    }
+
+    // Moves the window to end at sequence (the current match count) and
+    // sweeps some subjects; call it once per match
+    void advance(int sequence) {
+        int start = sequence - m_retention;
+        m_window_start = start > m_window_start ? start : m_window_start;
+        sweep(TEAM);
+        sweep(JOCKEY);
+    }
+
+    // Logs that the subject's record changed by delta at sequence, ending at
+    // recordAfter. prepare() must have been called for the subject.
+    void append(Kind kind, int id, int sequence, int delta, int recordAfter) {
+        Stream& stream = *m_streams[kind].find(id);
+        stream.m_pinned = false;
+        expire(stream);
+        Block* block = stream.m_count > 0 ? &m_blocks[stream.m_tail] : nullptr;
+        if (!block || block->m_used + MAX_ENTRY_BYTES > BLOCK_BYTES) {
+            // prepare() left room in the ring and in the pool
+            int index = take_block();
+            stream.m_ring[(stream.m_head + stream.m_count) & (stream.m_capacity - 1)] = index;
+            stream.m_count++;
+            stream.m_tail = index;
+            block = &m_blocks[index];
+            block->m_first_seq = sequence;
+            block->m_last_seq = sequence;
+            block->m_base = recordAfter - delta;
+            block->m_used = 0;
+        }
+        uint64_t seqDelta = static_cast<uint64_t>(sequence - block->m_last_seq);
+        int tag = delta == 1 ? 0 : delta == -1 ? 1 : 2;
+        put_varint(block->m_bytes, block->m_used, (seqDelta << 2) | static_cast<uint64_t>(tag));
+        if (tag == 2) {
+            put_varint(block->m_bytes, block->m_used, zigzag(delta));
+        }
+        block->m_last_seq = sequence;
+        if (stream.m_count == 1) {
+            stream.m_oldest_last = sequence;
+        }
+    }
+
+    // Record of the subject after sequence (no earlier than the window
+    // start), given its current record
+    int record_at(Kind kind, int id, int sequence, int current) const {
+        const Stream* stream = m_streams[kind].find(id);
+        if (!stream || stream->m_count == 0) {
+            return current;
+        }
+        // Last block that starts at or before sequence
+        int low = 0;
+        int high = stream->m_count;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (m_blocks[stream->block(middle)].m_first_seq <= sequence) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        // Before the first block nothing changed back to the window start
+        if (low == 0) {
+            return m_blocks[stream->block(0)].m_base;
+        }
+        return decode(m_blocks[stream->block(low - 1)], sequence);
+    }
+
+    long long memory_bytes() const {
+        long long bytes = static_cast<long long>(m_block_capacity) * sizeof(Block);
+        for (int kind = 0; kind < 2; ++kind) {
+            bytes += m_streams[kind].memory_bytes();
+            for (int i = 0; i < m_streams[kind].get_capacity(); ++i) {
+                const Stream* stream = m_streams[kind].slot(i);
+                bytes += stream ? static_cast<long long>(stream->m_capacity) * sizeof(int) : 0;
+            }
+        }
+        return bytes;
+    }
+
+    int get_live_blocks() const { return m_live_blocks; }
+};
+
+#endif // RECORD_HISTORY_H
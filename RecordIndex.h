@@ -0,0 +1,334 @@
+#ifndef RECORD_INDEX_H
+#define RECORD_INDEX_H
+
+#include <climits>
+#include <new>
+
+#include "HashPolicies.h"
+#include "Instrumentation.h"
+#include "SimdProbe.h"
+
+// Index from a record value to the live teams that currently have it.
+// Instead of one entry per team, every distinct record owns a single slot
+// holding the number of teams with that record and the XOR of their IDs, so
+// when exactly one team has the record its ID is the XOR itself.
+//
+// Records cluster around zero with a long tail, so there are two tiers:
+// - A dense window [m_dense_low, m_dense_low + m_dense_span) indexed
+//   directly by record. Moving a team by one point inside it touches two
+//   neighbouring array cells and never probes.
+// - A flat open-addressed overflow table for the records outside the window.
+//   Keys live in one contiguous int array probed a group of PROBE_GROUP_SIZE
+//   slots at a time (SimdProbe.h). Records whose count drops to zero keep
+//   their slot until the next rebuild, since records usually come back soon.
+// When a rebuild finds most overflow records just past the window, the window
+// doubles around zero and takes them over.
+class RecordIndex {
+private:
+    static constexpr int EMPTY = INT_MIN;           // Records never get that low
+    static constexpr int MIN_CAPACITY = 64;
+    static constexpr int INITIAL_RADIUS = 1024;
+    static constexpr int MAX_RADIUS = 1 << 20;
+
+    // Dense window
+    int* m_dense_counts;
+    int* m_dense_id_xors;
+    int m_dense_low;
+    int m_dense_span;
+
+    // Overflow table
+    int* m_keys;
+    int* m_counts;
+    int* m_id_xors;
+    int m_capacity;     // Power of two, multiple of PROBE_GROUP_SIZE
+    int m_used;         // Slots holding a key (including zero counts)
+    int m_live;         // Slots with a positive count
+
+    int m_entries;      // Teams in the index
+
+    // Offset of the record in the dense window, or -1 if it is outside
+    int dense_slot(int record) const {
+        unsigned int offset = static_cast<unsigned int>(record) - static_cast<unsigned int>(m_dense_low);
+        return offset < static_cast<unsigned int>(m_dense_span) ? static_cast<int>(offset) : -1;
+    }
+
+    PLAINS_STAT(mutable HashStats m_stats;)
+
+    int first_group(int record) const {
+        int groups = m_capacity / PROBE_GROUP_SIZE;
+        return PowerOfTwoGrowth::index(FibonacciHash::hash(record), groups) * PROBE_GROUP_SIZE;
+    }
+
+    // Slot of the record, or -1 if it is not in the table
+    int find_slot(int record) const {
+        int group = first_group(record);
+        PLAINS_STAT(ProbeCounter probes(m_stats);)
+        while (true) {
+            PLAINS_STAT(probes.step();)
+            GroupMatch match = match_group(m_keys + group, record, EMPTY);
+            if (match.m_key_mask) {
+                return group + __builtin_ctz(match.m_key_mask);
+            }
+            if (match.m_empty_mask) {
+                return -1;
+            }
+            group = (group + PROBE_GROUP_SIZE) & (m_capacity - 1);
+        }
+    }
+
+    // Slot of the record, claiming an empty slot if it is not there yet
+    int find_or_insert_slot(int record) {
+        int slot = find_slot(record);
+        if (slot >= 0) {
+            return slot;
+        }
+        reserve_slots(1);
+        int group = first_group(record);
+        while (true) {
+            GroupMatch match = match_group(m_keys + group, record, EMPTY);
+            if (match.m_empty_mask) {
+                slot = group + __builtin_ctz(match.m_empty_mask);
+                m_keys[slot] = record;
+                m_counts[slot] = 0;
+                m_id_xors[slot] = 0;
+                m_used++;
+                return slot;
+            }
+            group = (group + PROBE_GROUP_SIZE) & (m_capacity - 1);
+        }
+    }
+
+    // Doubles the dense window if most live overflow records would fit in it
+    void widen_window() {
+        int radius = -m_dense_low;
+        if (m_live == 0 || radius >= MAX_RADIUS) {
+            return;
+        }
+        int wider = 0;
+        for (int i = 0; i < m_capacity; ++i) {
+            if (m_keys[i] != EMPTY && m_counts[i] > 0 && m_keys[i] >= -2 * radius && m_keys[i] < 2 * radius) {
+                wider++;
+            }
+        }
+        if (wider * 2 <= m_live) {
+            return;
+        }
+
+        int span = 4 * radius;
+        int* counts = new int[span];
+        int* idXors = new (std::nothrow) int[span];
+        if (!idXors) {
+            delete[] counts;
+            throw std::bad_alloc();
+        }
+        for (int i = 0; i < span; ++i) {
+            counts[i] = 0;
+            idXors[i] = 0;
+        }
+        for (int i = 0; i < m_dense_span; ++i) {
+            counts[radius + i] = m_dense_counts[i];
+            idXors[radius + i] = m_dense_id_xors[i];
+        }
+        delete[] m_dense_counts;
+        delete[] m_dense_id_xors;
+        m_dense_counts = counts;
+        m_dense_id_xors = idXors;
+        m_dense_low = -2 * radius;
+        m_dense_span = span;
+
+        // The rebuild that follows drops the moved records from the overflow
+        for (int i = 0; i < m_capacity; ++i) {
+            int slot = m_keys[i] == EMPTY ? -1 : dense_slot(m_keys[i]);
+            if (slot >= 0 && m_counts[i] > 0) {
+                m_dense_counts[slot] = m_counts[i];
+                m_dense_id_xors[slot] = m_id_xors[i];
+                m_counts[i] = 0;
+                m_live--;
+            }
+        }
+    }
+
+    // Rehash the live overflow records into a table at most half full, with
+    // room for extra more
+    void rebuild(int extra) {
+        PLAINS_STAT(m_stats.m_rehashes++;)
+        PLAINS_STAT(ScopedTimer rebuild_timer(m_stats.m_rehash_ns);)
+        if (m_keys) {
+            widen_window();
+        }
+        int capacity = MIN_CAPACITY;
+        while (capacity < (m_live + extra) * 2) {
+            capacity *= 2;
+        }
+        int* keys = new int[capacity];
+        int* counts = new (std::nothrow) int[capacity];
+        int* idXors = counts ? new (std::nothrow) int[capacity] : nullptr;
+        if (!idXors) {
+            delete[] counts;
+            delete[] keys;
+            throw std::bad_alloc();
+        }
+        for (int i = 0; i < capacity; ++i) {
+            keys[i] = EMPTY;
+        }
+
+        int* oldKeys = m_keys;
+        int* oldCounts = m_counts;
+        int* oldIdXors = m_id_xors;
+        int oldCapacity = m_capacity;
+        m_keys = keys;
+        m_counts = counts;
+        m_id_xors = idXors;
+        m_capacity = capacity;
+        m_used = 0;
+
+        for (int i = 0; i < oldCapacity; ++i) {
+            if (oldKeys[i] == EMPTY || oldCounts[i] == 0) {
+                continue;
+            }
+            int group = first_group(oldKeys[i]);
+            while (true) {
+                GroupMatch match = match_group(m_keys + group, oldKeys[i], EMPTY);
+                if (match.m_empty_mask) {
+                    int slot = group + __builtin_ctz(match.m_empty_mask);
+                    m_keys[slot] = oldKeys[i];
+                    m_counts[slot] = oldCounts[i];
+                    m_id_xors[slot] = oldIdXors[i];
+                    m_used++;
+                    break;
+                }
+                group = (group + PROBE_GROUP_SIZE) & (m_capacity - 1);
+            }
+        }
+        delete[] oldKeys;
+        delete[] oldCounts;
+        delete[] oldIdXors;
+    }
+
+public:
+    RecordIndex() : m_dense_counts(nullptr), m_dense_id_xors(nullptr),
+                    m_dense_low(-INITIAL_RADIUS), m_dense_span(2 * INITIAL_RADIUS),
+                    m_keys(nullptr), m_counts(nullptr), m_id_xors(nullptr),
+                    m_capacity(0), m_used(0), m_live(0), m_entries(0) {
+        m_dense_counts = new int[m_dense_span]();
+        m_dense_id_xors = new (std::nothrow) int[m_dense_span]();
+        if (!m_dense_id_xors) {
+            delete[] m_dense_counts;
+            throw std::bad_alloc();
+        }
+        try {
+            rebuild(1);
+        } catch (std::bad_alloc&) {
+            delete[] m_dense_counts;
+            delete[] m_dense_id_xors;
+            throw;
+        }
+    }
+
+    ~RecordIndex() {
+        delete[] m_dense_counts;
+        delete[] m_dense_id_xors;
+        delete[] m_keys;
+        delete[] m_counts;
+        delete[] m_id_xors;
+    }
+
+    RecordIndex(const RecordIndex&) = delete;
+    RecordIndex& operator=(const RecordIndex&) = delete;
+
+    // Makes room for extra new records, so the next extra calls to add cannot
+    // run out of memory (records inside the dense window never need room).
+    // Call it before changing anything that must stay in sync.
+    void reserve_slots(int extra) {
+        if ((m_used + extra) * 8 > m_capacity * 7) {
+            rebuild(extra);
+        }
+    }
+
+    // Team id now has the given record
+    void add(int record, int id) {
+        int dense = dense_slot(record);
+        if (dense < 0) {
+            // Make room first: the rebuild may widen the window over the record
+            reserve_slots(1);
+            dense = dense_slot(record);
+        }
+        if (dense >= 0) {
+            m_dense_counts[dense]++;
+            m_dense_id_xors[dense] ^= id;
+            m_entries++;
+            return;
+        }
+        int slot = find_or_insert_slot(record);
+        if (m_counts[slot]++ == 0) {
+            m_live++;
+        }
+        m_id_xors[slot] ^= id;
+        m_entries++;
+    }
+
+    // Team id no longer has the given record (it must have been added)
+    void remove(int record, int id) {
+        int dense = dense_slot(record);
+        if (dense >= 0) {
+            if (m_dense_counts[dense] > 0) {
+                m_dense_counts[dense]--;
+                m_dense_id_xors[dense] ^= id;
+                m_entries--;
+            }
+            return;
+        }
+        int slot = find_slot(record);
+        if (slot < 0 || m_counts[slot] == 0) {
+            return;
+        }
+        if (--m_counts[slot] == 0) {
+            m_live--;
+        }
+        m_id_xors[slot] ^= id;
+        m_entries--;
+    }
+
+    // Team id moves from oldRecord to newRecord
+    void move(int oldRecord, int newRecord, int id) {
+        if (oldRecord != newRecord) {
+            remove(oldRecord, id);
+            add(newRecord, id);
+        }
+    }
+
+    // Number of teams with the given record
+    int count(int record) const {
+        int dense = dense_slot(record);
+        if (dense >= 0) {
+            return m_dense_counts[dense];
+        }
+        int slot = find_slot(record);
+        return slot < 0 ? 0 : m_counts[slot];
+    }
+
+    // ID of the only team with the given record, or 0 unless exactly one has it
+    int unique_id(int record) const {
+        int dense = dense_slot(record);
+        if (dense >= 0) {
+            return m_dense_counts[dense] == 1 ? m_dense_id_xors[dense] : 0;
+        }
+        int slot = find_slot(record);
+        return (slot >= 0 && m_counts[slot] == 1) ? m_id_xors[slot] : 0;
+    }
+
+    // Number of teams in the index
+    int get_size() const {
+        return m_entries;
+    }
+
+#ifdef PLAINS_INSTRUMENT
+    const HashStats& get_stats() const { return m_stats; }
+
+    int get_capacity() const { return m_capacity; }
+
+    int get_dense_span() const { return m_dense_span; }
+#endif
+};
+
+#endif // RECORD_INDEX_H
@@ -0,0 +1,175 @@
+#include "SimdProbe.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_PROBE_X86 1
+#include <immintrin.h>
+#endif
+
+static GroupMatch match_group_scalar(const int* group, int key, int empty) {
+    GroupMatch match = {0, 0};
+    for (int i = 0; i < PROBE_GROUP_SIZE; ++i) {
+        match.m_key_mask |= static_cast<unsigned int>(group[i] == key) << i;
+        match.m_empty_mask |= static_cast<unsigned int>(group[i] == empty) << i;
+    }
+    return match;
+}
+
+static int count_greater_scalar(const int* values, int count, int threshold) {
+    int matches = 0;
+    for (int i = 0; i < count; ++i) {
+        matches += values[i] > threshold;
+    }
+    return matches;
+}
+
+static long long sum_where_at_least_scalar(const int* values, const int* keys, int count, int threshold) {
+    long long sum = 0;
+    for (int i = 0; i < count; ++i) {
+        sum += keys[i] >= threshold ? values[i] : 0;
+    }
+    return sum;
+}
+
+#ifdef SIMD_PROBE_X86
+
+__attribute__((target("sse2")))
+static GroupMatch match_group_sse2(const int* group, int key, int empty) {
+    const __m128i keys = _mm_set1_epi32(key);
+    const __m128i empties = _mm_set1_epi32(empty);
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group + 4));
+    GroupMatch match;
+    match.m_key_mask =
+        static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(low, keys)))) |
+        static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(high, keys)))) << 4;
+    match.m_empty_mask =
+        static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(low, empties)))) |
+        static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(high, empties)))) << 4;
+    return match;
+}
+
+__attribute__((target("avx2")))
+static GroupMatch match_group_avx2(const int* group, int key, int empty) {
+    const __m256i slots = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(group));
+    GroupMatch match;
+    match.m_key_mask = static_cast<unsigned int>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(slots, _mm256_set1_epi32(key)))));
+    match.m_empty_mask = static_cast<unsigned int>(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(slots, _mm256_set1_epi32(empty)))));
+    return match;
+}
+
+// The column scans keep one counter (or two 64-bit sums) per lane and
+// finish the tail of fewer than a vector of rows with the scalar loop
+
+__attribute__((target("sse2")))
+static int count_greater_sse2(const int* values, int count, int threshold) {
+    const __m128i thresholds = _mm_set1_epi32(threshold);
+    __m128i counts = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        // A match is -1, so subtracting the comparison counts it
+        counts = _mm_sub_epi32(counts, _mm_cmpgt_epi32(v, thresholds));
+    }
+    int lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counts);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + count_greater_scalar(values + i, count - i, threshold);
+}
+
+__attribute__((target("sse2")))
+static long long sum_where_at_least_sse2(const int* values, const int* keys, int count, int threshold) {
+    const __m128i thresholds = _mm_set1_epi32(threshold);
+    __m128i sums = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        const __m128i selected = _mm_andnot_si128(_mm_cmpgt_epi32(thresholds, k), v);
+        // Sign-extends to 64 bits by interleaving with the sign words
+        const __m128i signs = _mm_srai_epi32(selected, 31);
+        sums = _mm_add_epi64(sums, _mm_unpacklo_epi32(selected, signs));
+        sums = _mm_add_epi64(sums, _mm_unpackhi_epi32(selected, signs));
+    }
+    long long lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+    return lanes[0] + lanes[1] + sum_where_at_least_scalar(values + i, keys + i, count - i, threshold);
+}
+
+__attribute__((target("avx2")))
+static int count_greater_avx2(const int* values, int count, int threshold) {
+    const __m256i thresholds = _mm256_set1_epi32(threshold);
+    __m256i counts = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        counts = _mm256_sub_epi32(counts, _mm256_cmpgt_epi32(v, thresholds));
+    }
+    int lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), counts);
+    int matches = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+        matches += lanes[lane];
+    }
+    return matches + count_greater_scalar(values + i, count - i, threshold);
+}
+
+__attribute__((target("avx2")))
+static long long sum_where_at_least_avx2(const int* values, const int* keys, int count, int threshold) {
+    const __m256i thresholds = _mm256_set1_epi32(threshold);
+    __m256i sums = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i));
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        const __m256i selected = _mm256_andnot_si256(_mm256_cmpgt_epi32(thresholds, k), v);
+        sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(selected)));
+        sums = _mm256_add_epi64(sums, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(selected, 1)));
+    }
+    long long lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sums);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           sum_where_at_least_scalar(values + i, keys + i, count - i, threshold);
+}
+
+#endif // SIMD_PROBE_X86
+
+GroupMatchFunction select_group_match() {
+#ifdef SIMD_PROBE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &match_group_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return &match_group_sse2;
+    }
+#endif
+    return &match_group_scalar;
+}
+
+const char* group_match_name() {
+    GroupMatchFunction implementation = select_group_match();
+#ifdef SIMD_PROBE_X86
+    if (implementation == &match_group_avx2) {
+        return "avx2";
+    }
+    if (implementation == &match_group_sse2) {
+        return "sse2";
+    }
+#endif
+    (void)implementation;
+    return "scalar";
+}
+
+ColumnScan select_column_scan() {
+#ifdef SIMD_PROBE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return ColumnScan{&count_greater_avx2, &sum_where_at_least_avx2};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return ColumnScan{&count_greater_sse2, &sum_where_at_least_sse2};
+    }
+#endif
+    return ColumnScan{&count_greater_scalar, &sum_where_at_least_scalar};
+}
@@ -0,0 +1,48 @@
+#ifndef SIMD_PROBE_H
+#define SIMD_PROBE_H
+
+// Vectorized key comparison for flat hash tables.
+// A group is PROBE_GROUP_SIZE consecutive int keys. match_group compares the
+// whole group against a key and against the empty marker at once and returns
+// one bit per slot. The implementation (AVX2, SSE2 or scalar) is picked once
+// at startup from CPUID, so the same binary runs on any x86-64 or other CPU.
+
+static constexpr int PROBE_GROUP_SIZE = 8;
+
+struct GroupMatch {
+    unsigned int m_key_mask;    // Bit i set if group[i] == key
+    unsigned int m_empty_mask;  // Bit i set if group[i] == empty
+};
+
+typedef GroupMatch (*GroupMatchFunction)(const int* group, int key, int empty);
+
+// The implementation selected for this CPU
+GroupMatchFunction select_group_match();
+
+// Name of the selected implementation ("avx2", "sse2" or "scalar")
+const char* group_match_name();
+
+// Compares a group of PROBE_GROUP_SIZE keys against key and empty
+inline GroupMatch match_group(const int* group, int key, int empty) {
+    static const GroupMatchFunction implementation = select_group_match();
+    return implementation(group, key, empty);
+}
+
+// Vectorized scans over int columns (TeamColumns.h), dispatched the same way.
+// Both walk count values of one or two equally long columns.
+struct ColumnScan {
+    // Number of values[i] > threshold
+    int (*m_count_greater)(const int* values, int count, int threshold);
+    // Sum of values[i] over the rows with keys[i] >= threshold
+    long long (*m_sum_where_at_least)(const int* values, const int* keys, int count, int threshold);
+};
+
+// The implementations selected for this CPU
+ColumnScan select_column_scan();
+
+inline const ColumnScan& column_scan() {
+    static const ColumnScan implementation = select_column_scan();
+    return implementation;
+}
+
+#endif // SIMD_PROBE_H
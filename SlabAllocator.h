@@ -0,0 +1,124 @@
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "Numa.h"
+
+// Fixed-size object allocator shared by many owners.
+// Objects are carved out of large slabs; released objects go to a freelist
+// and are handed out again before a new slab is touched, so creating and
+// destroying many small owners never returns memory to the system until the
+// allocator itself is destroyed. Objects still alive at that point must be
+// trivially destructible, since the allocator does not track them.
+template<typename T>
+class SlabAllocator {
+private:
+    union Slot {
+        Slot* m_next_free;
+        alignas(T) unsigned char m_storage[sizeof(T)];
+    };
+
+    struct Slab {
+        Slot* m_slots;
+        Slab* m_next;
+    };
+
+    Slab* m_slabs;
+    Slot* m_free;
+    int m_used;             // Slots handed out from the newest slab
+    int m_slab_size;
+    long long m_live;       // Objects currently allocated
+    int m_numa_node;        // Preferred node of the slabs, -1 for first touch
+
+    static constexpr int DEFAULT_SLAB_SIZE = 4096;
+
+public:
+    explicit SlabAllocator(int slabSize = DEFAULT_SLAB_SIZE)
+        : m_slabs(nullptr), m_free(nullptr), m_used(0), m_slab_size(slabSize), m_live(0),
+          m_numa_node(-1) {}
+
+    ~SlabAllocator() {
+        while (m_slabs) {
+            Slab* next = m_slabs->m_next;
+            delete[] m_slabs->m_slots;
+            delete m_slabs;
+            m_slabs = next;
+        }
+    }
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    // Constructs an object, reusing a released slot when there is one
+    template<typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot = m_free;
+        if (!slot) {
+            if (!m_slabs || m_used == m_slab_size) {
+                Slot* slots = new Slot[m_slab_size];
+                if (m_numa_node >= 0) {
+                    Numa::bind(slots, sizeof(Slot) * static_cast<std::size_t>(m_slab_size), m_numa_node);
+                }
+                Slab* slab = new (std::nothrow) Slab;
+                if (!slab) {
+                    delete[] slots;
+                    throw std::bad_alloc();
+                }
+                slab->m_slots = slots;
+                slab->m_next = m_slabs;
+                m_slabs = slab;
+                m_used = 0;
+            }
+            slot = m_slabs->m_slots + m_used;
+            T* item = new (slot->m_storage) T(std::forward<Args>(args)...);
+            m_used++;
+            m_live++;
+            return item;
+        }
+        // The object overwrites the link, so read it first
+        Slot* next = slot->m_next_free;
+        T* item = new (slot->m_storage) T(std::forward<Args>(args)...);
+        m_free = next;
+        m_live++;
+        return item;
+    }
+
+    // Destroys an object and keeps its slot for reuse
+    void release(T* item) {
+        item->~T();
+        Slot* slot = reinterpret_cast<Slot*>(item);
+        slot->m_next_free = m_free;
+        m_free = slot;
+        m_live--;
+    }
+
+    long long get_live() const {
+        return m_live;
+    }
+
+    // Prefers the given NUMA node for all slabs, moving the existing ones
+    // (-1: first touch again for new slabs)
+    void set_numa_node(int node) {
+        m_numa_node = node;
+        for (Slab* slab = m_slabs; slab && node >= 0; slab = slab->m_next) {
+            Numa::bind(slab->m_slots, sizeof(Slot) * static_cast<std::size_t>(m_slab_size), node);
+        }
+    }
+
+    // Adds the pages of every slab to the placement report
+    void add_placement(NumaPlacement& placement) const {
+        for (Slab* slab = m_slabs; slab; slab = slab->m_next) {
+            placement.add_range(slab->m_slots, sizeof(Slot) * static_cast<std::size_t>(m_slab_size));
+        }
+    }
+
+    // Bytes taken by one object, including its share of the slot
+    static constexpr std::size_t slot_bytes() {
+        return sizeof(Slot);
+    }
+};
+
+#endif // SLAB_ALLOCATOR_H
@@ -0,0 +1,98 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <sched.h>
+
+// Bounded single-producer / single-consumer ring buffer.
+// Exactly one thread may push and exactly one other thread may pop. The
+// head and tail counters live on separate cache lines and each side only
+// writes its own counter, so no locks are needed. The blocking calls spin
+// briefly and then yield, which keeps them usable on a single core.
+template<typename T>
+class SpscRing {
+private:
+    static constexpr int SPIN_LIMIT = 64;
+
+    T* m_items;
+    unsigned int m_mask;        // Capacity - 1, capacity is a power of two
+
+    alignas(64) std::atomic<unsigned int> m_head;   // Next slot to pop, written by the consumer
+    alignas(64) std::atomic<unsigned int> m_tail;   // Next slot to push, written by the producer
+    std::atomic<bool> m_closed;
+
+    static void wait(int& spins) {
+        if (++spins > SPIN_LIMIT) {
+            sched_yield();
+        }
+    }
+
+public:
+    // Capacity is rounded up to a power of two
+    explicit SpscRing(int capacity) : m_items(nullptr), m_mask(0), m_head(0), m_tail(0), m_closed(false) {
+        unsigned int size = 1;
+        while (static_cast<int>(size) < capacity) {
+            size *= 2;
+        }
+        m_items = new T[size];
+        m_mask = size - 1;
+    }
+
+    ~SpscRing() {
+        delete[] m_items;
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer: adds item unless the ring is full
+    bool try_push(const T& item) {
+        unsigned int tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+        m_items[tail & m_mask] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer: adds item, waiting for room
+    void push(const T& item) {
+        int spins = 0;
+        while (!try_push(item)) {
+            wait(spins);
+        }
+    }
+
+    // Producer: no more items will be pushed
+    void close() {
+        m_closed.store(true, std::memory_order_release);
+    }
+
+    // Consumer: takes the oldest item unless the ring is empty
+    bool try_pop(T& item) {
+        unsigned int head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_items[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: takes the oldest item, waiting for one. Returns false once the
+    // ring is closed and drained.
+    bool pop(T& item) {
+        int spins = 0;
+        while (!try_pop(item)) {
+            if (m_closed.load(std::memory_order_acquire)) {
+                // Items pushed before close are visible now
+                return try_pop(item);
+            }
+            wait(spins);
+        }
+        return true;
+    }
+};
+
+#endif // SPSC_RING_H
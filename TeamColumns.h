@@ -0,0 +1,133 @@
+#ifndef TEAM_COLUMNS_H
+#define TEAM_COLUMNS_H
+
+#include <cstdint>
+#include <new>
+
+#include "SimdProbe.h"
+
+// Read replica of the live teams as three parallel int columns: ID, record
+// and number of riders, one row per live team in no particular order. Scans
+// over all teams read contiguous memory instead of chasing map chains and
+// union-find nodes, and the filters run a vector of rows at a time
+// (SimdProbe.h).
+//
+// The owner keeps the replica up to date: a new team appends a row, record
+// and rider changes write their row in place, and a retired team's row is
+// filled with the last row (swap-remove), so the columns stay dense.
+class TeamColumns {
+private:
+    static constexpr int MIN_CAPACITY = 64;
+
+    int* m_ids;
+    int* m_records;
+    int* m_sizes;
+    int m_size;
+    int m_capacity;
+
+    void grow(int capacity) {
+        int* ids = new int[capacity];
+        int* records = nullptr;
+        int* sizes = nullptr;
+        try {
+            records = new int[capacity];
+            sizes = new int[capacity];
+        } catch (std::bad_alloc&) {
+            delete[] ids;
+            delete[] records;
+            throw;
+        }
+        for (int i = 0; i < m_size; ++i) {
+            ids[i] = m_ids[i];
+            records[i] = m_records[i];
+            sizes[i] = m_sizes[i];
+        }
+        delete[] m_ids;
+        delete[] m_records;
+        delete[] m_sizes;
+        m_ids = ids;
+        m_records = records;
+        m_sizes = sizes;
+        m_capacity = capacity;
+    }
+
+public:
+    TeamColumns() : m_ids(nullptr), m_records(nullptr), m_sizes(nullptr), m_size(0), m_capacity(0) {}
+
+    ~TeamColumns() {
+        delete[] m_ids;
+        delete[] m_records;
+        delete[] m_sizes;
+    }
+
+    TeamColumns(const TeamColumns&) = delete;
+    TeamColumns& operator=(const TeamColumns&) = delete;
+
+    // Makes room for count rows in total (doubling), so that the next adds
+    // up to that count cannot fail. Throws std::bad_alloc with nothing changed.
+    void reserve(int count) {
+        if (count <= m_capacity) {
+            return;
+        }
+        long long capacity = 2LL * m_capacity;
+        capacity = capacity < count ? count : capacity;
+        capacity = capacity < MIN_CAPACITY ? MIN_CAPACITY : capacity;
+        grow(capacity > INT32_MAX ? INT32_MAX : static_cast<int>(capacity));
+    }
+
+    // Appends a row (room must have been reserved) and returns its index
+    int add(int id, int record, int size) {
+        m_ids[m_size] = id;
+        m_records[m_size] = record;
+        m_sizes[m_size] = size;
+        return m_size++;
+    }
+
+    // Removes the row by moving the last row into it. Returns the ID of the
+    // moved team, whose row index is now row, or 0 if row was the last one.
+    int remove(int row) {
+        int last = --m_size;
+        if (row == last) {
+            return 0;
+        }
+        m_ids[row] = m_ids[last];
+        m_records[row] = m_records[last];
+        m_sizes[row] = m_sizes[last];
+        return m_ids[row];
+    }
+
+    void set_record(int row, int record) { m_records[row] = record; }
+    void add_record(int row, int delta) { m_records[row] += delta; }
+    void add_size(int row, int delta) { m_sizes[row] += delta; }
+
+    int get_size() const { return m_size; }
+    int get_record(int row) const { return m_records[row]; }
+    int get_team_size(int row) const { return m_sizes[row]; }
+
+    // The columns, get_size() rows each, for custom scans. Valid until the
+    // next change of the owner.
+    const int* ids() const { return m_ids; }
+    const int* records() const { return m_records; }
+    const int* sizes() const { return m_sizes; }
+
+    // Number of teams with a record above record
+    int count_record_above(int record) const {
+        return column_scan().m_count_greater(m_records, m_size, record);
+    }
+
+    // Number of teams with more than size riders
+    int count_size_above(int size) const {
+        return column_scan().m_count_greater(m_sizes, m_size, size);
+    }
+
+    // Sum of the records of the teams with at least minSize riders
+    long long sum_records(int minSize) const {
+        return column_scan().m_sum_where_at_least(m_records, m_sizes, m_size, minSize);
+    }
+
+    long long memory_bytes() const {
+        return 3LL * sizeof(int) * m_capacity;
+    }
+};
+
+#endif // TEAM_COLUMNS_H
@@ -0,0 +1,148 @@
+#include "ThreadPool.h"
+#include "Numa.h"
+#include <new>
+#include <unistd.h>
+
+ThreadPool::ThreadPool(int numThreads)
+    : m_threads(nullptr), m_starts(nullptr), m_ranges(nullptr), m_thread_count(1),
+      m_generation(0), m_active(0), m_stop(false), m_failed(false),
+      m_function(nullptr), m_context(nullptr), m_grain(1)
+{
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    pthread_mutex_init(&m_lock, nullptr);
+    pthread_cond_init(&m_start_cond, nullptr);
+    pthread_cond_init(&m_done_cond, nullptr);
+
+    m_ranges = new WorkerRange[numThreads];
+    m_threads = new pthread_t[numThreads];
+    m_starts = new WorkerStart[numThreads];
+    for (int i = 0; i < numThreads; ++i) {
+        m_ranges[i].m_next.store(0);
+        m_ranges[i].m_end = 0;
+    }
+
+    // Worker 0 is the calling thread; if a thread cannot be started we simply
+    // run with fewer workers
+    for (int i = 1; i < numThreads; ++i) {
+        m_starts[i].m_pool = this;
+        m_starts[i].m_index = i;
+        if (pthread_create(&m_threads[i], nullptr, &ThreadPool::worker_main, &m_starts[i]) != 0) {
+            break;
+        }
+        m_thread_count++;
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    pthread_mutex_lock(&m_lock);
+    m_stop = true;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_lock);
+    for (int i = 1; i < m_thread_count; ++i) {
+        pthread_join(m_threads[i], nullptr);
+    }
+    pthread_cond_destroy(&m_done_cond);
+    pthread_cond_destroy(&m_start_cond);
+    pthread_mutex_destroy(&m_lock);
+    delete[] m_starts;
+    delete[] m_threads;
+    delete[] m_ranges;
+}
+
+int ThreadPool::pin_to_node(int node) {
+    int pinned = 0;
+    for (int i = 1; i < m_thread_count; ++i) {
+        pinned += Numa::pin_thread(m_threads[i], node);
+    }
+    return pinned;
+}
+
+int ThreadPool::hardware_threads() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? static_cast<int>(count) : 1;
+}
+
+void* ThreadPool::worker_main(void* arg) {
+    WorkerStart* start = static_cast<WorkerStart*>(arg);
+    ThreadPool* pool = start->m_pool;
+    int seenGeneration = 0;
+    while (true) {
+        pthread_mutex_lock(&pool->m_lock);
+        while (!pool->m_stop && pool->m_generation == seenGeneration) {
+            pthread_cond_wait(&pool->m_start_cond, &pool->m_lock);
+        }
+        if (pool->m_stop) {
+            pthread_mutex_unlock(&pool->m_lock);
+            return nullptr;
+        }
+        seenGeneration = pool->m_generation;
+        pthread_mutex_unlock(&pool->m_lock);
+
+        pool->work(start->m_index);
+
+        pthread_mutex_lock(&pool->m_lock);
+        if (--pool->m_active == 0) {
+            pthread_cond_signal(&pool->m_done_cond);
+        }
+        pthread_mutex_unlock(&pool->m_lock);
+    }
+}
+
+void ThreadPool::work(int self) {
+    try {
+        for (int offset = 0; offset < m_thread_count; ++offset) {
+            WorkerRange& range = m_ranges[(self + offset) % m_thread_count];
+            while (true) {
+                int begin = range.m_next.fetch_add(m_grain);
+                if (begin >= range.m_end) {
+                    break;
+                }
+                int end = begin + m_grain < range.m_end ? begin + m_grain : range.m_end;
+                m_function(m_context, begin, end);
+            }
+        }
+    } catch (std::bad_alloc&) {
+        pthread_mutex_lock(&m_lock);
+        m_failed = true;
+        pthread_mutex_unlock(&m_lock);
+    }
+}
+
+void ThreadPool::run(RangeFunction function, const void* context, int count, int grain) {
+    if (grain < 1) {
+        grain = 1;
+    }
+    // Split [0, count) into one contiguous share per worker
+    int share = (count + m_thread_count - 1) / m_thread_count;
+    for (int i = 0; i < m_thread_count; ++i) {
+        long long begin = static_cast<long long>(share) * i;
+        long long end = begin + share;
+        m_ranges[i].m_next.store(begin < count ? static_cast<int>(begin) : count);
+        m_ranges[i].m_end = end < count ? static_cast<int>(end) : count;
+    }
+
+    pthread_mutex_lock(&m_lock);
+    m_function = function;
+    m_context = context;
+    m_grain = grain;
+    m_failed = false;
+    m_active = m_thread_count - 1;
+    m_generation++;
+    pthread_cond_broadcast(&m_start_cond);
+    pthread_mutex_unlock(&m_lock);
+
+    work(0);
+
+    pthread_mutex_lock(&m_lock);
+    while (m_active > 0) {
+        pthread_cond_wait(&m_done_cond, &m_lock);
+    }
+    bool failed = m_failed;
+    pthread_mutex_unlock(&m_lock);
+
+    if (failed) {
+        throw std::bad_alloc();
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <pthread.h>
+
+// Small fixed-size pool of worker threads for data-parallel loops.
+// parallel_for splits an index range evenly between the workers; a worker
+// that finishes its own share steals chunks from the shares of the others.
+// The calling thread takes part in the work and the call returns only once
+// every chunk has been processed, so results never depend on scheduling as
+// long as each chunk writes to its own disjoint part of the output.
+class ThreadPool {
+private:
+    typedef void (*RangeFunction)(const void* context, int begin, int end);
+
+    // Share of the current loop owned by one worker, padded to a cache line
+    struct WorkerRange {
+        std::atomic<int> m_next;
+        int m_end;
+        char m_padding[64 - sizeof(std::atomic<int>) - sizeof(int)];
+    };
+
+    struct WorkerStart {
+        ThreadPool* m_pool;
+        int m_index;
+    };
+
+    pthread_t* m_threads;
+    WorkerStart* m_starts;
+    WorkerRange* m_ranges;
+    int m_thread_count;     // Including the calling thread
+
+    pthread_mutex_t m_lock;
+    pthread_cond_t m_start_cond;
+    pthread_cond_t m_done_cond;
+    int m_generation;
+    int m_active;
+    bool m_stop;
+    bool m_failed;
+
+    RangeFunction m_function;
+    const void* m_context;
+    int m_grain;
+
+    static void* worker_main(void* arg);
+
+    // Process the own share and then steal from the other workers
+    void work(int self);
+
+    void run(RangeFunction function, const void* context, int count, int grain);
+
+    template<typename Body>
+    static void invoke_body(const void* context, int begin, int end) {
+        (*static_cast<const Body*>(context))(begin, end);
+    }
+
+public:
+    // Creates a pool with numThreads threads in total (the caller counts as one)
+    explicit ThreadPool(int numThreads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int get_thread_count() const {
+        return m_thread_count;
+    }
+
+    // Calls body(begin, end) on chunks of at most grain indices until [0, count)
+    // is covered. Throws std::bad_alloc if any chunk ran out of memory.
+    // Not reentrant: body must not call parallel_for on the same pool.
+    template<typename Body>
+    void parallel_for(int count, int grain, const Body& body) {
+        if (count <= 0) {
+            return;
+        }
+        if (m_thread_count == 1 || count <= grain) {
+            body(0, count);
+            return;
+        }
+        run(&invoke_body<Body>, &body, count, grain);
+    }
+
+    // Restricts the worker threads (not the caller) to the CPUs of a NUMA
+    // node, so memory they first touch lands there. Returns the number of
+    // workers pinned; 0 on single-node machines without CPU lists.
+    int pin_to_node(int node);
+
+    // Number of hardware threads available to the process (at least 1)
+    static int hardware_threads();
+};
+
+#endif // THREAD_POOL_H
@@ -61,6 +61,11 @@ int main()
         }
     }
 
+#ifdef PLAINS_INSTRUMENT
+    // Instrumented builds report their counters on stderr
+    obj->write_stats_json(cerr);
+#endif
+
     // Quit 
     delete obj;
     return 0;
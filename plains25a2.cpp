@@ -1,9 +1,17 @@
 #include "plains25a2.h"
 #include "GenericNode.h"
+#include "RadixSort.h"
 #include <cassert>
 
 
-Plains::Plains() : m_team_map(), m_jockey_map(), m_record_map() {
+Plains::Plains() : m_team_map(), m_jockey_map(), m_retired_ids(), m_forest(), m_record_index(), m_columns(),
+                   m_dirty_teams(new Team*[RECORD_QUEUE_CAPACITY]),
+                   m_dirty_nodes(new GenericNode<Jockey, Team>*[RECORD_QUEUE_CAPACITY]),
+                   m_dirty_count(0), m_lazy_records(false), m_nodes(),
+                   m_merges_since_compaction(0), m_compaction_threshold(0), m_absorbed_nodes(),
+                   m_absorbed_count(0), m_absorbed_capacity(0), m_relink_cursor(0), m_relink_steps(0),
+                   m_numa_node(-1), m_lookup_group(16), m_pool(), m_feed(), m_sketches(),
+                   m_match_count(0), m_history() {
 }
 
 // Releases the data structure (all allocated memory must be freed).
@@ -26,19 +34,23 @@ Plains::~Plains() {
 // • SUCCESS on success.
 // Time complexity: O(1) on average over the expected input.
 StatusType Plains::add_team(int teamId){
+    PLAINS_STAT(ScopedTimer op_timer(m_stats.m_operation_ns[PlainsStats::ADD_TEAM]);)
     try{
         if(teamId <= 0){
             return StatusType::INVALID_INPUT;
         }
-        if(m_team_map.get_value(teamId) == nullptr){
+        if(m_team_map.get_value(teamId) == nullptr && !m_retired_ids.contains(teamId)){
             shared_ptr<Team> team_ptr = make_shared<Team>(teamId);
-            GenericNode<Jockey, Team>* team_node = new GenericNode<Jockey, Team>(team_ptr);
-            
-            // Set the team node's parent to itself to denote it's a root
-            team_node->m_parent = team_node;
+            GenericNode<Jockey, Team>* team_node = m_nodes.create(team_ptr);
+            m_forest.make_set(team_node);
             
+            m_record_index.reserve_slots(1);
+            m_columns.reserve(m_columns.get_size() + 1);
             m_team_map.insert(teamId, team_node);
-            m_record_map.insert(team_ptr->m_record, m_team_map.get_value(teamId));
+            m_record_index.add(team_ptr->m_record, teamId);
+            team_ptr->m_indexed = true;
+            team_ptr->m_indexed_record = team_ptr->m_record;
+            team_ptr->m_column_row = m_columns.add(teamId, team_ptr->m_record, 0);
             return StatusType::SUCCESS;
         }else{
             return StatusType::FAILURE;
@@ -61,6 +73,7 @@ StatusType Plains::add_team(int teamId){
 // • SUCCESS on success.
 // Time complexity: O(1) on average over the expected input.
 StatusType Plains::add_jockey(int jockeyId, int teamId){
+    PLAINS_STAT(ScopedTimer op_timer(m_stats.m_operation_ns[PlainsStats::ADD_JOCKEY]);)
     try{
         if(jockeyId <= 0 || teamId <= 0){
             return StatusType::INVALID_INPUT;
@@ -69,11 +82,11 @@ StatusType Plains::add_jockey(int jockeyId, int teamId){
             return StatusType::FAILURE;
         }
         shared_ptr<Jockey> jockey_ptr = make_shared<Jockey>(jockeyId);
-        GenericNode<Jockey, Team>* jockey_node = new GenericNode<Jockey, Team>(jockey_ptr);
+        GenericNode<Jockey, Team>* jockey_node = m_nodes.create(jockey_ptr);
         GenericNode<Jockey, Team>* team_node = find_real_team_node(teamId);
-        jockey_node->m_parent = team_node;
-        team_node->m_size++;
+        m_forest.attach(jockey_node, team_node);
         m_jockey_map.insert(jockeyId, jockey_node);
+        m_columns.add_size(team_of(team_node)->m_column_row, 1);
         return StatusType::SUCCESS;
     }catch(std::bad_alloc& e){
         return StatusType::ALLOCATION_ERROR;
@@ -93,29 +106,71 @@ StatusType Plains::add_jockey(int jockeyId, int teamId){
 // • SUCCESS on success.
 // Time complexity: O(log* m) on average over the input evaluated together with merge_teams and unite_by_record.
 StatusType Plains::update_match(int victoriousJockeyId, int losingJockeyId){
+    PLAINS_STAT(ScopedTimer op_timer(m_stats.m_operation_ns[PlainsStats::UPDATE_MATCH]);)
     try{
         // Check for invalid inputs
         if(victoriousJockeyId <= 0 || losingJockeyId <= 0 || victoriousJockeyId == losingJockeyId){
             return StatusType::INVALID_INPUT;
         }
+        relink_absorbed();
         // Check if the jockeys exist and are in different teams and to update the records
         GenericNode<Jockey, Team>* victorious_jockey_node = m_jockey_map.get_value(victoriousJockeyId);
         GenericNode<Jockey, Team>* losing_jockey_node = m_jockey_map.get_value(losingJockeyId);
         if(victorious_jockey_node == nullptr || losing_jockey_node == nullptr || find_root(victorious_jockey_node) == find_root(losing_jockey_node)){
             return StatusType::FAILURE;
         }
+        prepare_record_update(2);
+        if (m_history) {
+            int victoriousTeamId = find_root(victorious_jockey_node)->m_data->m_id;
+            int losingTeamId = find_root(losing_jockey_node)->m_data->m_id;
+            try{
+                m_history->prepare(RecordHistory::JOCKEY, victoriousJockeyId);
+                m_history->prepare(RecordHistory::JOCKEY, losingJockeyId);
+                m_history->prepare(RecordHistory::TEAM, victoriousTeamId);
+                m_history->prepare(RecordHistory::TEAM, losingTeamId);
+            }catch(std::bad_alloc& e){
+                // The match is not played, so no stream may stay pinned
+                m_history->unpin(RecordHistory::JOCKEY, victoriousJockeyId);
+                m_history->unpin(RecordHistory::JOCKEY, losingJockeyId);
+                m_history->unpin(RecordHistory::TEAM, victoriousTeamId);
+                m_history->unpin(RecordHistory::TEAM, losingTeamId);
+                throw;
+            }
+        }
         // Update the records
         victorious_jockey_node->m_data->increase_record();
         losing_jockey_node->m_data->decrease_record();
         GenericNode<Jockey, Team>* victorious_team_node = find_root(victorious_jockey_node);
         GenericNode<Jockey, Team>* losing_team_node = find_root(losing_jockey_node);
-        victorious_team_node->m_data->m_record++;
-        losing_team_node->m_data->m_record--;
-        // Update the record map
-        m_record_map.remove_pair(victorious_team_node->m_data->m_record, victorious_team_node);
-        m_record_map.remove_pair(losing_team_node->m_data->m_record, losing_team_node);
-        m_record_map.insert(victorious_team_node->m_data->m_record, victorious_team_node);
-        m_record_map.insert(losing_team_node->m_data->m_record, losing_team_node);
+        Participant* victorious_team = victorious_team_node->m_data.get();
+        Participant* losing_team = losing_team_node->m_data.get();
+        victorious_team->m_record++;
+        losing_team->m_record--;
+        m_forest.add_to_set(victorious_team_node, 1);
+        m_forest.add_to_set(losing_team_node, -1);
+        m_columns.add_record(team_of(victorious_team_node)->m_column_row, 1);
+        m_columns.add_record(team_of(losing_team_node)->m_column_row, -1);
+        // Update the record index
+        mark_record_dirty(team_of(victorious_team_node));
+        mark_record_dirty(team_of(losing_team_node));
+        finish_record_update();
+        if (m_feed) {
+            m_feed->publish(ChangeEvent::RECORD_CHANGED, victorious_team->m_id, 0, 1);
+            m_feed->publish(ChangeEvent::RECORD_CHANGED, losing_team->m_id, 0, -1);
+        }
+        if (m_sketches) {
+            m_sketches->record_match(victoriousJockeyId, losingJockeyId, victorious_team->m_id, losing_team->m_id);
+        }
+        m_match_count++;
+        if (m_history) {
+            m_history->advance(m_match_count);
+            m_history->append(RecordHistory::JOCKEY, victoriousJockeyId, m_match_count, 1,
+                              victorious_jockey_node->m_data->m_record);
+            m_history->append(RecordHistory::JOCKEY, losingJockeyId, m_match_count, -1,
+                              losing_jockey_node->m_data->m_record);
+            m_history->append(RecordHistory::TEAM, victorious_team->m_id, m_match_count, 1, victorious_team->m_record);
+            m_history->append(RecordHistory::TEAM, losing_team->m_id, m_match_count, -1, losing_team->m_record);
+        }
         return StatusType::SUCCESS;
     }catch(std::bad_alloc& e){
         return StatusType::ALLOCATION_ERROR;
@@ -136,10 +191,12 @@ StatusType Plains::update_match(int victoriousJockeyId, int losingJockeyId){
 // • SUCCESS on success.
 // Time complexity: O(log* m) on average over the input considered together with unite_by_record and update_match.
 StatusType Plains::merge_teams(int teamId1, int teamId2){
+    PLAINS_STAT(ScopedTimer op_timer(m_stats.m_operation_ns[PlainsStats::MERGE_TEAMS]);)
     try{
         if(teamId1 <= 0 || teamId2 <= 0 || teamId1 == teamId2){
             return StatusType::INVALID_INPUT;
         }
+        relink_absorbed();
 
         GenericNode<Jockey, Team>* team_node_ptr1 = find_real_team_node(teamId1);
         GenericNode<Jockey, Team>* team_node_ptr2 = find_real_team_node(teamId2);
@@ -148,19 +205,79 @@ StatusType Plains::merge_teams(int teamId1, int teamId2){
             return StatusType::FAILURE;
         }
 
-        if(team_node_ptr1->m_size < team_node_ptr2->m_size){
-            std::swap(team_node_ptr1, team_node_ptr2);
-            std::swap(teamId1, teamId2);
+        // The team with the better record keeps its ID (teamId1 on a tie)
+        Team* survivor = team_of(team_node_ptr1);
+        Team* absorbed = team_of(team_node_ptr2);
+        if (absorbed->m_record > survivor->m_record) {
+            std::swap(survivor, absorbed);
+        }
+
+        // The forest's linking policy decides which node stays the root,
+        // independently of the ID. The root must carry the surviving team, so
+        // if it is the other one the two nodes trade teams and the team map
+        // follows.
+        GenericNode<Jockey, Team>* root = m_forest.pick_root(team_node_ptr1, team_node_ptr2);
+        GenericNode<Jockey, Team>* child = root == team_node_ptr1 ? team_node_ptr2 : team_node_ptr1;
+
+        prepare_record_update(2);
+        reserve_absorbed(m_absorbed_count + 1);
+        m_retired_ids.prepare(absorbed->m_id);
+        int absorbedId = absorbed->m_id;
+        int absorbedRecord = absorbed->m_record;
+        if (m_history && absorbedRecord != 0) {
+            m_history->prepare(RecordHistory::TEAM, survivor->m_id);
+        }
+        if (root->m_data.get() != survivor) {
+            m_team_map.assign(survivor->m_id, root);
+            std::swap(root->m_data, child->m_data);
+        }
+        // Adds the absorbed team's record to the survivor
+        m_forest.link(root, child);
+        // The absorbed ID leaves the map; its tombstone keeps add_team failing
+        m_team_map.remove_and_get_values(absorbed->m_id);
+        m_retired_ids.insert(absorbed->m_id);
+        absorbed->m_retired = true;
+        // Linking by size never changes a child's weight, so a weight of 1
+        // means that no rider or team was ever linked under the node
+        bool anchorsRiders = child->m_size > 1;
+        if (anchorsRiders) {
+            m_absorbed_nodes[m_absorbed_count++] = child;
+        }
+        if (m_history && absorbedRecord != 0) {
+            m_history->append(RecordHistory::TEAM, survivor->m_id, m_match_count, absorbedRecord,
+                              survivor->m_record);
+        }
+
+        // The survivor's row takes the combined team; the absorbed row is
+        // refilled with the last row, whose team has to learn its new row
+        m_columns.set_record(survivor->m_column_row, survivor->m_record);
+        m_columns.add_size(survivor->m_column_row, m_columns.get_team_size(absorbed->m_column_row));
+        int movedId = m_columns.remove(absorbed->m_column_row);
+        if (movedId != 0) {
+            team_of(m_team_map.get_value(movedId))->m_column_row = absorbed->m_column_row;
         }
+        absorbed->m_column_row = -1;
+
+        // Update the record index: the absorbed team leaves it, the merged
+        // team moves to the combined record. The absorbed team itself is no
+        // longer needed once the index has dropped it, so its node goes
+        // along: a node that anchors nothing is recycled for the next add,
+        // the others stay until compact_nodes has repointed their riders.
+        mark_record_dirty(survivor);
+        mark_team_absorbed(absorbed, child);
+        finish_record_update();
 
-        team_node_ptr1->m_size += team_node_ptr2->m_size;
-        team_node_ptr2->m_parent = team_node_ptr1;
+        if (m_feed) {
+            m_feed->publish(ChangeEvent::TEAMS_MERGED, survivor->m_id, absorbedId, survivor->m_record);
+            m_feed->publish(ChangeEvent::TEAM_RETIRED, absorbedId);
+        }
 
-        // Update the record map
-        m_record_map.remove_pair(team_node_ptr1->m_data->m_record, team_node_ptr1);
-        m_record_map.remove_pair(team_node_ptr2->m_data->m_record, team_node_ptr2);
-        team_node_ptr1->m_data->m_record += team_node_ptr2->m_data->m_record;
-        m_record_map.insert(team_node_ptr1->m_data->m_record, team_node_ptr1);
+        // Compaction is only an optimization: the merge stands even if it fails.
+        // It is O(n + m), so bounded-latency mode never runs it implicitly.
+        if (m_relink_steps == 0 && m_compaction_threshold > 0 &&
+            ++m_merges_since_compaction >= m_compaction_threshold) {
+            compact_nodes();
+        }
 
         return StatusType::SUCCESS;
 
@@ -183,31 +300,23 @@ StatusType Plains::merge_teams(int teamId1, int teamId2){
 // Time complexity: O(log* m) on average over input evaluated together with update_match and merge_teams.
 StatusType Plains::unite_by_record(int record)
 {
+    PLAINS_STAT(ScopedTimer op_timer(m_stats.m_operation_ns[PlainsStats::UNITE_BY_RECORD]);)
     try{
         if(record <= 0){
             return StatusType::INVALID_INPUT;
         }
 
-        if(m_record_map.check_duplicates(record) || m_record_map.check_duplicates(-record)){
-            return StatusType::FAILURE;
-        }
-
-
-        // Find teams with the given record and -record
-        GenericNode<Jockey, Team>* team1 = m_record_map.get_value(record);
-        GenericNode<Jockey, Team>* team2 = m_record_map.get_value(-record);
-
-        
-        if (!team1 || !team2) {
+        // Exactly one team must have each of record and -record. The index
+        // keeps one slot per record holding the team count and the XOR of
+        // their IDs, so a single lookup answers each side.
+        flush_record_index();
+        int teamId1 = m_record_index.unique_id(record);
+        int teamId2 = m_record_index.unique_id(-record);
+        if (teamId1 == 0 || teamId2 == 0) {
             return StatusType::FAILURE;
         }
 
-        if(record == 5){
-            GenericNode<Jockey, Team>* team3 = m_record_map.get_value(15);
-            cout << "team1: " << team1->m_data->m_id << " team2: " << team2->m_data->m_id << " team3: " << team3->m_data->m_id << endl;
-        }
-
-        return merge_teams(team1->m_data->m_id, team2->m_data->m_id);
+        return merge_teams(teamId1, teamId2);
 
     }catch(std::bad_alloc& e){
         return StatusType::ALLOCATION_ERROR;
@@ -227,6 +336,7 @@ StatusType Plains::unite_by_record(int record)
 // • SUCCESS if successful, in which case the rider’s record is returned as well.
 // Time complexity: O(1) on average over the input.
 output_t<int> Plains::get_jockey_record(int jockeyId){
+    PLAINS_STAT(ScopedTimer op_timer(m_stats.m_operation_ns[PlainsStats::GET_JOCKEY_RECORD]);)
     try{
         if(jockeyId <= 0){
             return output_t<int>(StatusType::INVALID_INPUT);
@@ -253,6 +363,7 @@ output_t<int> Plains::get_jockey_record(int jockeyId){
 // • SUCCESS if successful, in which case the team’s record is also returned.
 // Time complexity: O(1) on average over the input.
 output_t<int> Plains::get_team_record(int teamId){
+    PLAINS_STAT(ScopedTimer op_timer(m_stats.m_operation_ns[PlainsStats::GET_TEAM_RECORD]);)
     try{
         if(teamId <= 0){
             return output_t<int>(StatusType::INVALID_INPUT);
@@ -266,4 +377,965 @@ output_t<int> Plains::get_team_record(int teamId){
     }catch(std::bad_alloc& e){
         return output_t<int>(StatusType::ALLOCATION_ERROR);
     }
-}
\ No newline at end of file
+}
+
+// Returns the record of the team the rider with ID jockeyId currently rides for.
+
+// Parameters:
+// • jockeyId: the ID of the rider.
+
+// Return value:
+// • INVALID_INPUT if jockeyId <= 0.
+// • FAILURE if there's no rider with ID jockeyId.
+// • SUCCESS if successful, in which case the team's record is returned as well.
+// Time complexity: O(log* m) on average over the input evaluated together with merge_teams and unite_by_record.
+output_t<int> Plains::get_jockey_team_record(int jockeyId)
+{
+    if(jockeyId <= 0){
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    GenericNode<Jockey, Team>* jockey_node = m_jockey_map.get_value(jockeyId);
+    if(jockey_node == nullptr){
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(find_root(jockey_node)->m_data->m_record);
+}
+
+// Returns the net record of the rider's teams over the matches they played
+// while the rider was on them: every match win of a teammate (the rider
+// included) counts +1, every loss -1. Each update_match adds its result to
+// the team root's edge offset, so the sum along the rider's path is the answer.
+
+// Parameters:
+// • jockeyId: the ID of the rider.
+
+// Return value:
+// • INVALID_INPUT if jockeyId <= 0.
+// • FAILURE if there's no rider with ID jockeyId.
+// • SUCCESS if successful, in which case the net record is returned as well.
+// Time complexity: O(log* m) on average over the input evaluated together with merge_teams and unite_by_record.
+output_t<int> Plains::get_team_record_since_joined(int jockeyId)
+{
+    if(jockeyId <= 0){
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    GenericNode<Jockey, Team>* jockey_node = m_jockey_map.get_value(jockeyId);
+    if(jockey_node == nullptr){
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(m_forest.value(jockey_node));
+}
+
+// Turns the match stream sketches on (empty) or off.
+
+// Parameters:
+// • enabled: whether update_match should feed the sketches.
+
+// Return value:
+// • ALLOCATION_ERROR if the sketches could not be allocated.
+// • SUCCESS on success.
+// Time complexity: O(1).
+StatusType Plains::set_match_sketches(bool enabled)
+{
+    try{
+        m_sketches.reset(enabled ? new MatchSketches() : nullptr);
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Sets the window of the distinct rider count.
+
+// Parameters:
+// • matches: matches per window, or 0 for a single window.
+
+// Return value:
+// • INVALID_INPUT if matches < 0.
+// • FAILURE if the sketches are off.
+// • SUCCESS on success.
+// Time complexity: O(1).
+StatusType Plains::set_sketch_window(int matches)
+{
+    if (matches < 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    if (!m_sketches) {
+        return StatusType::FAILURE;
+    }
+    m_sketches->set_window(matches);
+    return StatusType::SUCCESS;
+}
+
+// Estimates the distinct riders that played in a window (1.6% standard error).
+
+// Parameters:
+// • previousWindow: the last complete window instead of the current one.
+
+// Return value:
+// • FAILURE if the sketches are off.
+// • SUCCESS, with the estimate.
+// Time complexity: O(1) (a pass over the 4096 registers).
+output_t<long long> Plains::estimate_active_jockeys(bool previousWindow)
+{
+    if (!m_sketches) {
+        return output_t<long long>(StatusType::FAILURE);
+    }
+    return output_t<long long>(m_sketches->active_jockeys(previousWindow));
+}
+
+// Estimates the wins of a rider since the sketches were enabled.
+
+// Parameters:
+// • jockeyId: the rider (who need not exist).
+
+// Return value:
+// • INVALID_INPUT if jockeyId <= 0.
+// • FAILURE if the sketches are off.
+// • SUCCESS, with the estimate.
+// Time complexity: O(1).
+output_t<long long> Plains::estimate_jockey_wins(int jockeyId)
+{
+    if (jockeyId <= 0) {
+        return output_t<long long>(StatusType::INVALID_INPUT);
+    }
+    if (!m_sketches) {
+        return output_t<long long>(StatusType::FAILURE);
+    }
+    return output_t<long long>(m_sketches->jockey_wins(jockeyId));
+}
+
+// Lists the riders with the most wins.
+
+// Parameters:
+// • jockeyIds / wins / capacity: receive up to capacity riders and their estimated wins.
+
+// Return value:
+// • INVALID_INPUT if capacity < 0 or the arrays are missing.
+// • FAILURE if the sketches are off.
+// • SUCCESS, with the number of riders written.
+// Time complexity: O(1) (at most SpaceSaving::CAPACITY riders are tracked).
+output_t<int> Plains::top_winning_jockeys(int* jockeyIds, long long* wins, int capacity)
+{
+    if (capacity < 0 || (capacity > 0 && (!jockeyIds || !wins))) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    if (!m_sketches) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(m_sketches->top_winners(jockeyIds, wins, capacity));
+}
+
+// Lists the teams that played the most matches.
+
+// Parameters:
+// • teamIds / matches / capacity: receive up to capacity teams and their estimated matches.
+
+// Return value:
+// • INVALID_INPUT if capacity < 0 or the arrays are missing.
+// • FAILURE if the sketches are off.
+// • SUCCESS, with the number of teams written.
+// Time complexity: O(1) (at most SpaceSaving::CAPACITY teams are tracked).
+output_t<int> Plains::top_active_teams(int* teamIds, long long* matches, int capacity)
+{
+    if (capacity < 0 || (capacity > 0 && (!teamIds || !matches))) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    if (!m_sketches) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(m_sketches->top_teams(teamIds, matches, capacity));
+}
+
+// Turns the record history on, changes its retention, or turns it off.
+
+// Parameters:
+// • retentionMatches: the number of recent matches to keep, or 0 for off.
+
+// Return value:
+// • ALLOCATION_ERROR if the history could not be allocated.
+// • INVALID_INPUT if retentionMatches < 0.
+// • SUCCESS on success.
+// Time complexity: O(1), or O(kept changes) to turn it off.
+StatusType Plains::set_record_history(int retentionMatches)
+{
+    if (retentionMatches < 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        if (retentionMatches == 0) {
+            m_history.reset();
+        } else if (m_history) {
+            m_history->set_retention(retentionMatches);
+        } else {
+            m_history.reset(new RecordHistory(retentionMatches, m_match_count));
+        }
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Returns the record team teamId had right after match matchCount.
+
+// Parameters:
+// • teamId: the live team.
+// • matchCount: the point in time, as a match count.
+
+// Return value:
+// • INVALID_INPUT if teamId <= 0 or matchCount < 0.
+// • FAILURE if the history is off, matchCount is outside its window or
+//   there is no team with ID teamId.
+// • SUCCESS, with the record.
+// Time complexity: O(log n) in the kept changes of the team.
+output_t<int> Plains::get_team_record_at(int teamId, int matchCount)
+{
+    if (teamId <= 0 || matchCount < 0) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    GenericNode<Jockey, Team>* node = find_real_team_node(teamId);
+    if (!m_history || !node || matchCount < m_history->get_window_start() || matchCount > m_match_count) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(m_history->record_at(RecordHistory::TEAM, teamId, matchCount, node->m_data->m_record));
+}
+
+// Returns the record rider jockeyId had right after match matchCount.
+
+// Parameters:
+// • jockeyId: the rider.
+// • matchCount: the point in time, as a match count.
+
+// Return value:
+// • INVALID_INPUT if jockeyId <= 0 or matchCount < 0.
+// • FAILURE if the history is off, matchCount is outside its window or
+//   there is no rider with ID jockeyId.
+// • SUCCESS, with the record.
+// Time complexity: O(log n) in the kept changes of the rider.
+output_t<int> Plains::get_jockey_record_at(int jockeyId, int matchCount)
+{
+    if (jockeyId <= 0 || matchCount < 0) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    GenericNode<Jockey, Team>* node = m_jockey_map.get_value(jockeyId);
+    if (!m_history || !node || matchCount < m_history->get_window_start() || matchCount > m_match_count) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    return output_t<int>(m_history->record_at(RecordHistory::JOCKEY, jockeyId, matchCount, node->m_data->m_record));
+}
+
+// Returns how much the record of rider jockeyId changed over the last lastMatches matches.
+
+// Return value:
+// • INVALID_INPUT if jockeyId <= 0 or lastMatches < 0.
+// • FAILURE as for get_jockey_record_at(jockeyId, get_match_count() - lastMatches).
+// • SUCCESS, with the change.
+// Time complexity: O(log n) in the kept changes of the rider.
+output_t<int> Plains::get_jockey_record_change(int jockeyId, int lastMatches)
+{
+    if (jockeyId <= 0 || lastMatches < 0) {
+        return output_t<int>(StatusType::INVALID_INPUT);
+    }
+    if (lastMatches > m_match_count) {
+        return output_t<int>(StatusType::FAILURE);
+    }
+    output_t<int> before = get_jockey_record_at(jockeyId, m_match_count - lastMatches);
+    if (before.status() != StatusType::SUCCESS) {
+        return before;
+    }
+    return output_t<int>(m_jockey_map.get_value(jockeyId)->m_data->m_record - before.ans());
+}
+
+// Counts the live teams whose record is above record.
+
+// Parameters:
+// • record: the threshold (any value).
+
+// Return value:
+// • SUCCESS, with the number of teams.
+// Time complexity: O(n) in the worst case, a vector of teams at a time.
+output_t<int> Plains::count_teams_above_record(int record) const
+{
+    return output_t<int>(m_columns.count_record_above(record));
+}
+
+// Sums the records of the live teams with at least minJockeys riders.
+
+// Parameters:
+// • minJockeys: the minimum number of riders of a counted team.
+
+// Return value:
+// • INVALID_INPUT if minJockeys < 0.
+// • SUCCESS, with the sum.
+// Time complexity: O(n) in the worst case, a vector of teams at a time.
+output_t<long long> Plains::sum_team_records(int minJockeys) const
+{
+    if (minJockeys < 0) {
+        return output_t<long long>(StatusType::INVALID_INPUT);
+    }
+    return output_t<long long>(m_columns.sum_records(minJockeys));
+}
+
+// Batched version of get_jockey_record.
+
+// Parameters:
+// • jockeyIds / count: the riders to look up.
+// • statuses / records: receive the status and (on SUCCESS) the record of every rider.
+
+// Return value:
+// • INVALID_INPUT if count < 0 or a non-empty array is missing.
+// • SUCCESS otherwise (the per-row statuses may still contain failures).
+// Time complexity: O(count) on average over the input.
+StatusType Plains::get_jockey_records(const int* jockeyIds, int count, StatusType* statuses, int* records)
+{
+    if (count < 0 || (count > 0 && (!jockeyIds || !statuses || !records))) {
+        return StatusType::INVALID_INPUT;
+    }
+    for (int begin = 0; begin < count; begin += m_lookup_group) {
+        int size = count - begin < m_lookup_group ? count - begin : m_lookup_group;
+        if (size > 1) {
+            prefetch_jockeys(jockeyIds + begin, size, false);
+        }
+        for (int i = begin; i < begin + size; ++i) {
+            output_t<int> result = get_jockey_record(jockeyIds[i]);
+            statuses[i] = result.status();
+            records[i] = result.status() == StatusType::SUCCESS ? result.ans() : 0;
+        }
+    }
+    return StatusType::SUCCESS;
+}
+
+// Batched version of update_match; the matches are applied in order.
+
+// Parameters:
+// • victoriousJockeyIds / losingJockeyIds / count: the matches.
+// • statuses: receives the result of every match.
+
+// Return value:
+// • INVALID_INPUT if count < 0 or a non-empty array is missing.
+// • SUCCESS otherwise (the per-row statuses may still contain failures).
+// Time complexity: O(count log* m) on average over the input evaluated together with merge_teams and unite_by_record.
+StatusType Plains::update_matches(const int* victoriousJockeyIds, const int* losingJockeyIds, int count,
+                                  StatusType* statuses)
+{
+    if (count < 0 || (count > 0 && (!victoriousJockeyIds || !losingJockeyIds || !statuses))) {
+        return StatusType::INVALID_INPUT;
+    }
+    for (int begin = 0; begin < count; begin += m_lookup_group) {
+        int size = count - begin < m_lookup_group ? count - begin : m_lookup_group;
+        if (size > 1) {
+            prefetch_jockeys(victoriousJockeyIds + begin, size, true);
+            prefetch_jockeys(losingJockeyIds + begin, size, true);
+        }
+        for (int i = begin; i < begin + size; ++i) {
+            statuses[i] = update_match(victoriousJockeyIds[i], losingJockeyIds[i]);
+        }
+    }
+    return StatusType::SUCCESS;
+}
+
+// Sets how many operations of a batch are prefetched together.
+
+// Parameters:
+// • groupSize: 1 (no prefetching) to MAX_LOOKUP_GROUP.
+
+// Return value:
+// • INVALID_INPUT if groupSize is out of range.
+// • SUCCESS on success.
+// Time complexity: O(1).
+StatusType Plains::set_lookup_group(int groupSize)
+{
+    if (groupSize < 1 || groupSize > MAX_LOOKUP_GROUP) {
+        return StatusType::INVALID_INPUT;
+    }
+    m_lookup_group = groupSize;
+    return StatusType::SUCCESS;
+}
+
+void Plains::prefetch_jockeys(const int* jockeyIds, int count, bool withTeams)
+{
+    GenericNode<Jockey, Team>* nodes[MAX_LOOKUP_GROUP];
+    for (int i = 0; i < count; ++i) {
+        m_jockey_map.prefetch_bucket(jockeyIds[i]);
+    }
+    for (int i = 0; i < count; ++i) {
+        m_jockey_map.prefetch_chain(jockeyIds[i]);
+    }
+    for (int i = 0; i < count; ++i) {
+        nodes[i] = m_jockey_map.get_value(jockeyIds[i]);
+        if (nodes[i]) {
+            __builtin_prefetch(nodes[i]);
+        }
+    }
+    for (int i = 0; i < count; ++i) {
+        if (nodes[i]) {
+            __builtin_prefetch(nodes[i]->m_data.get());
+            if (withTeams) {
+                __builtin_prefetch(nodes[i]->m_parent);
+            }
+        }
+    }
+    if (withTeams) {
+        for (int i = 0; i < count; ++i) {
+            if (nodes[i]) {
+                __builtin_prefetch(nodes[i]->m_parent->m_data.get());
+            }
+        }
+    }
+}
+
+// Uses numThreads threads (including the caller) for bulk loads and for
+// rehashing large tables. 1 turns the worker threads off again.
+// The resulting structure is identical to a sequential build.
+StatusType Plains::set_worker_threads(int numThreads)
+{
+    if (numThreads <= 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        ThreadPool* pool = numThreads > 1 ? new ThreadPool(numThreads) : nullptr;
+        if (pool && m_numa_node >= 0) {
+            pool->pin_to_node(m_numa_node);
+        }
+        m_team_map.set_thread_pool(pool);
+        m_jockey_map.set_thread_pool(pool);
+        m_pool.reset(pool);
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Switches record index maintenance between eager and lazy.
+
+// Parameters:
+// • lazy: true to defer reindexing until unite_by_record needs the index.
+
+// Return value:
+// • ALLOCATION_ERROR if the pending updates could not be applied when leaving lazy mode.
+// • SUCCESS on success.
+// Time complexity: O(1), or O(RECORD_QUEUE_CAPACITY) when leaving lazy mode.
+StatusType Plains::set_lazy_record_index(bool lazy)
+{
+    try{
+        if (!lazy) {
+            flush_record_index();
+        }
+        m_lazy_records = lazy;
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Renumbers the union-find nodes so that every team is contiguous in memory.
+// The live team nodes and all jockey nodes are copied into one new block,
+// grouped by the ID of their team with the team first; parents are rewritten
+// to the team nodes (so every path has length at most 1 afterwards) and the
+// ID maps are repointed. The old nodes, absorbed team nodes included, are
+// released at the end.
+
+// Return value:
+// • ALLOCATION_ERROR if the new block or the scratch arrays could not be allocated
+//   (the structure is unchanged in that case).
+// • SUCCESS on success.
+// Time complexity: O(n + m) in the worst case.
+StatusType Plains::compact_nodes()
+{
+    try{
+        m_merges_since_compaction = 0;
+        // Absorbed teams still queued for the record index release their nodes first
+        flush_record_index();
+        int teamCount = m_team_map.get_size();
+        int count = teamCount + m_jockey_map.get_size();
+        if (count == 0) {
+            return StatusType::SUCCESS;
+        }
+        std::unique_ptr<GenericNode<Jockey, Team>*[]> nodes(new GenericNode<Jockey, Team>*[count]);
+        std::unique_ptr<unsigned int[]> keys(new unsigned int[count]);
+        std::unique_ptr<unsigned int[]> tmpKeys(new unsigned int[count]);
+        std::unique_ptr<int[]> rows(new int[count]);
+        std::unique_ptr<int[]> tmpRows(new int[count]);
+        NodeArena<GenericNode<Jockey, Team>> arena;
+        arena.set_numa_node(m_numa_node);
+        GenericNode<Jockey, Team>* block = arena.allocate_block(count);
+
+        // Team nodes (all roots) are listed first so the stable sort puts
+        // each one at the head of its group
+        int next = 0;
+        m_team_map.for_each([&](int, GenericNode<Jockey, Team>* node) {
+            nodes[next++] = node;
+        });
+        m_jockey_map.for_each([&](int, GenericNode<Jockey, Team>* node) {
+            nodes[next++] = node;
+        });
+        for (int i = 0; i < count; ++i) {
+            keys[i] = static_cast<unsigned int>(find_root(nodes[i])->m_data->m_id);
+            rows[i] = i;
+        }
+        radix_sort_pairs(keys.get(), rows.get(), count, tmpKeys.get(), tmpRows.get());
+
+        // Nothing below allocates. tmpRows now holds the position of every
+        // node's group head, so the copy can run in any order.
+        for (int i = 0; i < count; ++i) {
+            tmpRows[i] = (i > 0 && keys[i] == keys[i - 1]) ? tmpRows[i - 1] : i;
+        }
+        auto copy_range = [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                GenericNode<Jockey, Team>* source = nodes[rows[i]];
+                GenericNode<Jockey, Team>* target = block + i;
+                target->m_data = std::move(source->m_data);
+                target->m_size = source->m_size;
+                // Every path was compressed above, so the offset is already
+                // relative to the root
+                target->m_offset = source->m_offset;
+                target->m_parent = block + tmpRows[i];
+            }
+        };
+        if (m_pool) {
+            m_pool->parallel_for(count, 4096, copy_range);
+        } else {
+            copy_range(0, count);
+        }
+        m_absorbed_count = 0;
+        m_relink_cursor = 0;
+        for (int i = 0; i < count; ++i) {
+            NodeMap& map = rows[i] < teamCount ? m_team_map : m_jockey_map;
+            map.assign(block[i].m_data->m_id, block + i);
+        }
+        m_nodes.swap(arena);
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Sets how many successful merges trigger an automatic compact_nodes.
+
+// Parameters:
+// • mergeCount: the number of merges, or 0 to turn automatic compaction off.
+
+// Return value:
+// • INVALID_INPUT if mergeCount < 0.
+// • SUCCESS on success.
+// Time complexity: O(1).
+StatusType Plains::set_compaction_threshold(int mergeCount)
+{
+    if (mergeCount < 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    m_compaction_threshold = mergeCount;
+    m_merges_since_compaction = 0;
+    return StatusType::SUCCESS;
+}
+
+// Switches bounded-latency mode on or off.
+
+// Parameters:
+// • relinkSteps: relink steps per update_match / merge_teams, or 0 to turn the mode off.
+
+// Return value:
+// • INVALID_INPUT if relinkSteps < 0.
+// • SUCCESS on success.
+// Time complexity: O(1).
+StatusType Plains::set_bounded_latency(int relinkSteps)
+{
+    if (relinkSteps < 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    m_relink_steps = relinkSteps;
+    m_merges_since_compaction = 0;
+    return StatusType::SUCCESS;
+}
+
+// Grows the ID maps and the absorbed node list ahead of time. The record
+// index is left alone: it grows with the number of distinct records, which
+// stays small, and an oversized overflow table only costs cache misses.
+
+// Parameters:
+// • numTeams: the number of teams to make room for (past and present).
+// • numJockeys: the number of riders to make room for.
+
+// Return value:
+// • ALLOCATION_ERROR in case of a memory allocation problem.
+// • INVALID_INPUT if numTeams < 0 or numJockeys < 0.
+// • SUCCESS on success.
+// Time complexity: O(n + m + numTeams + numJockeys) in the worst case.
+StatusType Plains::reserve_capacity(int numTeams, int numJockeys)
+{
+    if (numTeams < 0 || numJockeys < 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    try{
+        m_team_map.reserve(numTeams);
+        m_jockey_map.reserve(numJockeys);
+        reserve_absorbed(numTeams);
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Sets the preferred NUMA node of this Plains.
+
+// Parameters:
+// • node: a node below Numa::node_count(), or -1 for first-touch placement.
+
+// Return value:
+// • INVALID_INPUT if node is out of range.
+// • SUCCESS otherwise, also when the system ignores the placement.
+// Time complexity: O(n + m) in the worst case, for moving existing pages.
+StatusType Plains::set_numa_node(int node)
+{
+    if (node < -1 || node >= Numa::node_count()) {
+        return StatusType::INVALID_INPUT;
+    }
+    m_numa_node = node;
+    m_nodes.set_numa_node(node);
+    m_team_map.set_numa_node(node);
+    m_jockey_map.set_numa_node(node);
+    if (m_pool && node >= 0) {
+        m_pool->pin_to_node(node);
+    }
+    return StatusType::SUCCESS;
+}
+
+// Samples the placement of the large allocations page by page.
+// Time complexity: O(number of sampled pages).
+void Plains::write_placement_report(std::ostream& os) const
+{
+    NumaPlacement arena;
+    NumaPlacement teamMap;
+    NumaPlacement jockeyMap;
+    m_nodes.add_placement(arena);
+    m_team_map.add_placement(teamMap);
+    m_jockey_map.add_placement(jockeyMap);
+    os << "{\"nodes\": " << Numa::node_count()
+       << ", \"preferred_node\": " << m_numa_node
+       << ", \"current_node\": " << Numa::current_node()
+       << ", \"node_arena\": ";
+    arena.write_json(os);
+    os << ", \"team_map\": ";
+    teamMap.write_json(os);
+    os << ", \"jockey_map\": ";
+    jockeyMap.write_json(os);
+    os << "}" << std::endl;
+}
+
+// Returns the change feed, creating it on the first call.
+// Return value: the feed, or nullptr in case of a memory allocation problem.
+// Time complexity: O(CHANGE_FEED_CAPACITY) on the first call, O(1) afterwards.
+ChangeFeed* Plains::change_feed()
+{
+    try{
+        if (!m_feed) {
+            m_feed.reset(new ChangeFeed(CHANGE_FEED_CAPACITY));
+        }
+        return m_feed.get();
+    }catch(std::bad_alloc& e){
+        return nullptr;
+    }
+}
+
+void Plains::reserve_absorbed(int count)
+{
+    if (count <= m_absorbed_capacity) {
+        return;
+    }
+    int capacity = m_absorbed_capacity ? 2 * m_absorbed_capacity : 64;
+    capacity = capacity < count ? count : capacity;
+    GenericNode<Jockey, Team>** nodes = new GenericNode<Jockey, Team>*[capacity];
+    for (int i = 0; i < m_absorbed_count; ++i) {
+        nodes[i] = m_absorbed_nodes[i];
+    }
+    m_absorbed_nodes.reset(nodes);
+    m_absorbed_capacity = capacity;
+}
+
+void Plains::relink_absorbed()
+{
+    // A node stays at the cursor until it hangs directly under its root
+    for (int step = 0; step < m_relink_steps && m_absorbed_count > 0; ++step) {
+        if (m_forest.relink_step(m_absorbed_nodes[m_relink_cursor])) {
+            m_relink_cursor = m_relink_cursor + 1 < m_absorbed_count ? m_relink_cursor + 1 : 0;
+        }
+    }
+}
+
+void Plains::prepare_record_update(int count)
+{
+    if (m_dirty_count + count > RECORD_QUEUE_CAPACITY) {
+        flush_record_index();
+    }
+    if (!m_lazy_records) {
+        // Each queued team takes at most one new slot when it is reindexed
+        m_record_index.reserve_slots(m_dirty_count + count);
+    }
+    // Each queued entry releases at most one node when it is flushed
+    m_nodes.reserve_recycled(m_dirty_count + count);
+}
+
+void Plains::mark_record_dirty(Team* team)
+{
+    if (!team->m_dirty) {
+        team->m_dirty = true;
+        m_dirty_teams[m_dirty_count] = team;
+        m_dirty_nodes[m_dirty_count++] = nullptr;
+    }
+}
+
+void Plains::mark_team_absorbed(Team* team, GenericNode<Jockey, Team>* node)
+{
+    // Queued even if the team already is: this entry must come last, as
+    // releasing the node releases the team
+    team->m_dirty = true;
+    m_dirty_teams[m_dirty_count] = team;
+    m_dirty_nodes[m_dirty_count++] = node;
+}
+
+void Plains::flush_record_index()
+{
+    // Reserve first, so a failure leaves the queue intact for the next try
+    m_record_index.reserve_slots(m_dirty_count);
+    m_nodes.reserve_recycled(m_dirty_count);
+    for (int i = 0; i < m_dirty_count; ++i) {
+        Team* team = m_dirty_teams[i];
+        team->m_dirty = false;
+        bool isLive = !team->m_retired;
+        if (team->m_indexed && isLive && team->m_indexed_record == team->m_record) {
+            continue;
+        }
+        if (team->m_indexed) {
+            m_record_index.remove(team->m_indexed_record, team->m_id);
+        }
+        team->m_indexed = isLive;
+        if (isLive) {
+            team->m_indexed_record = team->m_record;
+            m_record_index.add(team->m_record, team->m_id);
+        }
+        GenericNode<Jockey, Team>* node = m_dirty_nodes[i];
+        if (node) {
+            // Linking by size never changes a child's weight, so a weight of
+            // 1 means that nothing hangs off the node
+            if (node->m_size > 1) {
+                node->m_data.reset();
+            } else {
+                m_nodes.recycle(node);
+            }
+        }
+    }
+    m_dirty_count = 0;
+}
+
+void Plains::finish_record_update()
+{
+    if (!m_lazy_records) {
+        flush_record_index();
+    }
+}
+
+// Reports every row of a bulk_load batch that could not be applied as
+// ALLOCATION_ERROR (the batch may have failed before all rows were validated).
+static void mark_rows_failed(StatusType* results, int count)
+{
+    for (int row = 0; row < count; ++row) {
+        results[row] = StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Validates one column of IDs for bulk_load.
+// Rows with a non-positive ID get INVALID_INPUT. The remaining rows are
+// grouped by ID with a linear-time radix sort of (id, row) pairs; within each
+// group the earliest row accepted by canInsert gets SUCCESS and every other
+// row gets FAILURE, just like repeated single inserts would.
+template<typename Predicate>
+static int validate_bulk_ids(const int* ids, const int* secondaryIds, int count,
+                             StatusType* results, Predicate canInsert)
+{
+    std::unique_ptr<unsigned int[]> keys(new unsigned int[count]);
+    std::unique_ptr<unsigned int[]> tmpKeys(new unsigned int[count]);
+    std::unique_ptr<int[]> rows(new int[count]);
+    std::unique_ptr<int[]> tmpRows(new int[count]);
+
+    int valid = 0;
+    for (int row = 0; row < count; ++row) {
+        if (ids[row] <= 0 || (secondaryIds && secondaryIds[row] <= 0)) {
+            results[row] = StatusType::INVALID_INPUT;
+            continue;
+        }
+        keys[valid] = static_cast<unsigned int>(ids[row]);
+        rows[valid] = row;
+        valid++;
+    }
+
+    radix_sort_pairs(keys.get(), rows.get(), valid, tmpKeys.get(), tmpRows.get());
+
+    int accepted = 0;
+    bool groupTaken = false;
+    for (int i = 0; i < valid; ++i) {
+        if (i == 0 || keys[i] != keys[i - 1]) {
+            groupTaken = false;
+        }
+        if (!groupTaken && canInsert(rows[i])) {
+            results[rows[i]] = StatusType::SUCCESS;
+            groupTaken = true;
+            accepted++;
+        } else {
+            results[rows[i]] = StatusType::FAILURE;
+        }
+    }
+    return accepted;
+}
+
+// Bulk version of add_team and add_jockey for initial league loads.
+
+// Parameters:
+// • teamIds / numTeams: the teams to add.
+// • jockeyIds / jockeyTeamIds / numJockeys: the riders to add and their teams.
+// • teamResults / jockeyResults: receive the status of every row, exactly as
+//   add_team / add_jockey would have returned it for that row.
+
+// Return value:
+// • ALLOCATION_ERROR in case of a memory allocation/release problem. The
+//   team rows and the rider rows are each applied in full or not at all;
+//   every row of a part that was not applied reports ALLOCATION_ERROR.
+// • INVALID_INPUT if a count is negative or a non-empty array is missing.
+// • SUCCESS otherwise (the per-row statuses may still contain failures).
+// Time complexity: O(n + m) on average over the expected input, where n and m
+// are the number of team and jockey rows. Each hash table is resized at most
+// once and the new nodes are written into one contiguous block per kind.
+// With worker threads configured, the hash tables are filled in parallel.
+StatusType Plains::bulk_load(const int* teamIds, int numTeams,
+                             const int* jockeyIds, const int* jockeyTeamIds, int numJockeys,
+                             StatusType* teamResults, StatusType* jockeyResults)
+{
+    if (numTeams < 0 || numJockeys < 0) {
+        return StatusType::INVALID_INPUT;
+    }
+    if (numTeams > 0 && (!teamIds || !teamResults)) {
+        return StatusType::INVALID_INPUT;
+    }
+    if (numJockeys > 0 && (!jockeyIds || !jockeyTeamIds || !jockeyResults)) {
+        return StatusType::INVALID_INPUT;
+    }
+    // Whole batches are applied or not: after a failure every row of a batch
+    // that was not applied reports ALLOCATION_ERROR
+    bool teamsApplied = false;
+    try{
+        // Teams: reject duplicates inside the batch and IDs used in the past
+        int newTeams = validate_bulk_ids(teamIds, nullptr, numTeams, teamResults,
+            [&](int row) {
+                return m_team_map.get_value(teamIds[row]) == nullptr && !m_retired_ids.contains(teamIds[row]);
+            });
+
+        if (newTeams > 0) {
+            // Everything that can throw comes first: until the map insert
+            // succeeds the new nodes are not reachable from anywhere
+            m_record_index.reserve_slots(1);
+            m_columns.reserve(m_columns.get_size() + newTeams);
+            // Separate statement: if the control block cannot be allocated,
+            // shared_ptr deletes the array, and GCC would destroy the elements
+            // a second time when the new-expression shares the full-expression
+            Team* teamArray = new Team[newTeams];
+            shared_ptr<Team> teams(teamArray, std::default_delete<Team[]>());
+            GenericNode<Jockey, Team>* team_nodes = m_nodes.allocate_block(newTeams);
+            std::unique_ptr<int[]> keys(new int[newTeams]);
+            std::unique_ptr<GenericNode<Jockey, Team>*[]> values(new GenericNode<Jockey, Team>*[newTeams]);
+            int next = 0;
+            for (int row = 0; row < numTeams; ++row) {
+                if (teamResults[row] != StatusType::SUCCESS) {
+                    continue;
+                }
+                Team* team = teams.get() + next;
+                team->m_id = teamIds[row];
+                GenericNode<Jockey, Team>* team_node = team_nodes + next;
+                // Every node shares the control block of the whole team array
+                team_node->m_data = shared_ptr<Participant>(teams, team);
+                m_forest.make_set(team_node);
+                keys[next] = team->m_id;
+                values[next] = team_node;
+                next++;
+            }
+            m_team_map.insert_bulk(keys.get(), values.get(), newTeams);
+            for (int i = 0; i < newTeams; ++i) {
+                Team* team = team_of(values[i]);
+                m_record_index.add(team->m_record, team->m_id);
+                team->m_indexed = true;
+                team->m_indexed_record = team->m_record;
+                team->m_column_row = m_columns.add(team->m_id, team->m_record, 0);
+            }
+        }
+
+        teamsApplied = true;
+
+        // Jockeys: reject duplicates, known riders and orphans (no such team)
+        int newJockeys = validate_bulk_ids(jockeyIds, jockeyTeamIds, numJockeys, jockeyResults,
+            [&](int row) {
+                return m_jockey_map.get_value(jockeyIds[row]) == nullptr &&
+                       find_real_team_node(jockeyTeamIds[row]) != nullptr;
+            });
+
+        if (newJockeys > 0) {
+            Jockey* jockeyArray = new Jockey[newJockeys];
+            shared_ptr<Jockey> jockeys(jockeyArray, std::default_delete<Jockey[]>());
+            GenericNode<Jockey, Team>* jockey_nodes = m_nodes.allocate_block(newJockeys);
+            std::unique_ptr<int[]> keys(new int[newJockeys]);
+            std::unique_ptr<GenericNode<Jockey, Team>*[]> values(new GenericNode<Jockey, Team>*[newJockeys]);
+            std::unique_ptr<GenericNode<Jockey, Team>*[]> team_nodes(new GenericNode<Jockey, Team>*[newJockeys]);
+            int next = 0;
+            for (int row = 0; row < numJockeys; ++row) {
+                if (jockeyResults[row] != StatusType::SUCCESS) {
+                    continue;
+                }
+                Jockey* jockey = jockeys.get() + next;
+                jockey->m_id = jockeyIds[row];
+                GenericNode<Jockey, Team>* jockey_node = jockey_nodes + next;
+                jockey_node->m_data = shared_ptr<Participant>(jockeys, jockey);
+                keys[next] = jockey->m_id;
+                values[next] = jockey_node;
+                team_nodes[next] = find_real_team_node(jockeyTeamIds[row]);
+                next++;
+            }
+            m_jockey_map.insert_bulk(keys.get(), values.get(), newJockeys);
+            for (int i = 0; i < newJockeys; ++i) {
+                m_forest.attach(values[i], team_nodes[i]);
+                m_columns.add_size(team_of(team_nodes[i])->m_column_row, 1);
+            }
+        }
+        return StatusType::SUCCESS;
+    }catch(std::bad_alloc& e){
+        if (!teamsApplied) {
+            mark_rows_failed(teamResults, numTeams);
+        }
+        mark_rows_failed(jockeyResults, numJockeys);
+        return StatusType::ALLOCATION_ERROR;
+    }
+}
+
+// Writes the instrumentation collected so far as a single JSON object:
+// per-operation latency histograms (ns), find_root path lengths and the
+// probe / rehash counters of every hash table. Without PLAINS_INSTRUMENT
+// nothing is collected and the object is empty.
+void Plains::write_stats_json(std::ostream& os) const
+{
+#ifdef PLAINS_INSTRUMENT
+    os << "{\"operations_ns\": {";
+    for (int op = 0; op < PlainsStats::OPERATION_COUNT; ++op) {
+        os << (op ? ", " : "") << "\"" << PlainsStats::operation_name(op) << "\": ";
+        m_stats.m_operation_ns[op].write_json(os);
+    }
+    os << "}, \"find_path_length\": ";
+    m_stats.m_find_path.write_json(os);
+    os << ", \"team_map\": ";
+    m_team_map.get_stats().write_json(os, m_team_map.get_size(), m_team_map.get_capacity());
+    os << ", \"jockey_map\": ";
+    m_jockey_map.get_stats().write_json(os, m_jockey_map.get_size(), m_jockey_map.get_capacity());
+    os << ", \"record_index\": ";
+    m_record_index.get_stats().write_json(os, m_record_index.get_size(), m_record_index.get_capacity());
+    os << ", \"record_window\": " << m_record_index.get_dense_span();
+    os << ", \"record_probe\": \"" << group_match_name() << "\"";
+    os << "}" << std::endl;
+#else
+    os << "{}" << std::endl;
+#endif
+}
@@ -17,35 +17,162 @@
 #include "HashMap.h"
 #include "GenericNode.h"
 #include "Participant.h"
+#include "NodeArena.h"
+#include "ThreadPool.h"
+#include "Instrumentation.h"
+#include "RecordIndex.h"
+#include "TeamColumns.h"
+#include "ChangeFeed.h"
+#include "MatchSketches.h"
+#include "RecordHistory.h"
+#include "IdSet.h"
+#include "Dsu.h"
+#include "Numa.h"
 
 class Plains {
 private:
 
-    HashMap<GenericNode<Jockey, Team>> m_team_map;
-    HashMap<GenericNode<Jockey, Team>> m_jockey_map;
-    HashMap<GenericNode<Jockey, Team>> m_record_map;
+    // IDs and records are plain ints: power-of-two tables with Fibonacci hashing
+    typedef HashMap<GenericNode<Jockey, Team>, int, FibonacciHash, PowerOfTwoGrowth> NodeMap;
 
-    // Finds the root team of the given teamId (just the "super-team")
-    GenericNode<Jockey, Team>* find_real_team_node(int teamId) const
-    {
-        GenericNode<Jockey, Team>* teamNodePtr = m_team_map.get_value(teamId);
-        if (!teamNodePtr) {
-            return nullptr;
+    // m_team_map only holds live teams, whose nodes are always roots
+    NodeMap m_team_map;
+    NodeMap m_jockey_map;
+
+    // IDs of the teams absorbed by merges, which can never be added again
+    IdSet m_retired_ids;
+
+    // Forest payload: linking a team root under another adds its team's
+    // record to the surviving team (a rider joins with a record of 0)
+    struct TeamRecordAggregate {
+        template<typename S>
+        void combine(S&, GenericNode<Jockey, Team>* root, GenericNode<Jockey, Team>* child) {
+            root->m_data->m_record += child->m_data->m_record;
         }
-        if (teamNodePtr->m_parent != teamNodePtr) {
-            return nullptr;
+
+        template<typename S>
+        void split(S&, GenericNode<Jockey, Team>* root, GenericNode<Jockey, Team>* child) {
+            root->m_data->m_record -= child->m_data->m_record;
         }
-        return teamNodePtr;
+    };
+
+    // Union-find over the team and jockey nodes: union by size, full path
+    // compression. Edge offsets accumulate every match result of a team onto
+    // all of its current members (get_team_record_since_joined).
+    Dsu<WeightedPointerStorage<GenericNode<Jockey, Team>>, LinkBySize, FullCompression,
+        TeamRecordAggregate> m_forest;
+
+    // Live (root) teams by record, used by unite_by_record
+    RecordIndex m_record_index;
+
+    // Columnar replica of the live teams (ID, record, riders) for scans
+    TeamColumns m_columns;
+
+    // Teams whose record index entry is stale. In eager mode the queue is
+    // drained at the end of every change; in lazy mode only before the index
+    // is queried or when it fills up.
+    static constexpr int RECORD_QUEUE_CAPACITY = 1024;
+    std::unique_ptr<Team*[]> m_dirty_teams;
+    // Node of each queued team retired by a merge, released once the index
+    // has dropped the team (nullptr for the other entries)
+    std::unique_ptr<GenericNode<Jockey, Team>*[]> m_dirty_nodes;
+    int m_dirty_count;
+    bool m_lazy_records;
+
+    // Owns every team and jockey node; released together with the Plains
+    NodeArena<GenericNode<Jockey, Team>> m_nodes;
+
+    // Successful merges since the last compaction, and the count that
+    // triggers an automatic compact_nodes (0: never)
+    int m_merges_since_compaction;
+    int m_compaction_threshold;
+
+    // Every absorbed team node that still anchors riders, in merge order
+    // (the others are recycled once the record index has dropped their
+    // team). Riders hang off team nodes, so once these point straight at
+    // their roots every find is at most two hops; compact_nodes repoints the
+    // riders and drops them all. In bounded-latency mode update_match and
+    // merge_teams each spend m_relink_steps relink steps sweeping the list
+    // round-robin.
+    std::unique_ptr<GenericNode<Jockey, Team>*[]> m_absorbed_nodes;
+    int m_absorbed_count;
+    int m_absorbed_capacity;
+    int m_relink_cursor;
+    int m_relink_steps;
+
+    // Preferred NUMA node of the nodes, the map buckets and the workers
+    // (-1: first touch by whichever thread allocates)
+    int m_numa_node;
+
+    // Jockey IDs per group of the batched operations; each group's lookups
+    // are prefetched stage by stage before the group runs (1: no prefetching)
+    int m_lookup_group;
+    static constexpr int MAX_LOOKUP_GROUP = 64;
+
+    // Worker threads for bulk loads and large rehashes (none by default)
+    std::unique_ptr<ThreadPool> m_pool;
+
+    // Record and merge events for subscribers, created on first use
+    std::unique_ptr<ChangeFeed> m_feed;
+    static constexpr int CHANGE_FEED_CAPACITY = 1 << 16;
+
+    // Statistics of the update_match stream, while enabled
+    std::unique_ptr<MatchSketches> m_sketches;
+
+    // Successful matches so far, the sequence number of the record history
+    int m_match_count;
+
+    // Record changes by match sequence number, while enabled
+    std::unique_ptr<RecordHistory> m_history;
+
+    // Instrumentation counters (an empty stand-in unless PLAINS_INSTRUMENT
+    // is defined, see Instrumentation.h)
+    mutable PlainsStats m_stats;
+
+    // Finds the node of the live team teamId (a root), or nullptr
+    GenericNode<Jockey, Team>* find_real_team_node(int teamId) const
+    {
+        return m_team_map.get_value(teamId);
     }
 
-    GenericNode<Jockey, Team>* find_root(GenericNode<Jockey, Team>* node) const {
-        if (!node) {
-            return nullptr;
-        }
-        if (node->m_parent != node) {
-            node = find_root(node->m_parent); // Path compression
-        }
-        return node->m_parent;
+    static Team* team_of(const GenericNode<Jockey, Team>* teamNode) {
+        return static_cast<Team*>(teamNode->m_data.get());
+    }
+
+    // Makes sure the next count calls to mark_record_dirty or
+    // mark_team_absorbed and the following flush cannot fail. Call it before
+    // changing any record.
+    void prepare_record_update(int count);
+
+    // Queues the live team for reindexing
+    void mark_record_dirty(Team* team);
+
+    // Queues the team just retired by a merge together with its old node.
+    // The flush drops the team from the index, then recycles the node or,
+    // if riders still hang off it, only releases the team.
+    void mark_team_absorbed(Team* team, GenericNode<Jockey, Team>* node);
+
+    // Brings the record index up to date with every queued team
+    void flush_record_index();
+
+    // Drains the queue right away unless the lazy mode is on
+    void finish_record_update();
+
+    // Prefetches what looking up count (<= MAX_LOOKUP_GROUP) jockeys touches:
+    // map buckets, chain nodes, the union-find nodes and their riders, and
+    // with withTeams also the parents and their teams, one stage for the
+    // whole group at a time so the misses of a stage overlap
+    void prefetch_jockeys(const int* jockeyIds, int count, bool withTeams);
+
+    // Makes room for count absorbed team nodes
+    void reserve_absorbed(int count);
+
+    // One slice of the background relinking (nothing outside bounded mode)
+    void relink_absorbed();
+
+    GenericNode<Jockey, Team>* find_root(GenericNode<Jockey, Team>* node) {
+        m_stats.record_find_path(node);
+        return m_forest.find(node);
     }
 
 
@@ -61,6 +188,146 @@ public:
     output_t<int> get_jockey_record(int jockeyId);
     output_t<int> get_team_record(int teamId);
     // } </DO-NOT-MODIFY>---------------
+
+    // Loads many teams and jockeys at once, as if add_team was called for
+    // every team row in order and then add_jockey for every jockey row.
+    // The status of each row is written to teamResults / jockeyResults.
+    StatusType bulk_load(const int* teamIds, int numTeams,
+                         const int* jockeyIds, const int* jockeyTeamIds, int numJockeys,
+                         StatusType* teamResults, StatusType* jockeyResults);
+
+    // Batched get_jockey_record: statuses[i] and records[i] (0 unless
+    // SUCCESS) are the result for jockeyIds[i]. Lookups of a group are
+    // interleaved to overlap their cache misses; results are identical to
+    // calling get_jockey_record in order.
+    StatusType get_jockey_records(const int* jockeyIds, int count, StatusType* statuses, int* records);
+
+    // Batched update_match, applied in order: statuses[i] is the result of
+    // update_match(victoriousJockeyIds[i], losingJockeyIds[i])
+    StatusType update_matches(const int* victoriousJockeyIds, const int* losingJockeyIds, int count,
+                              StatusType* statuses);
+
+    // Sets the group size of the batched operations (1 runs them as a plain loop)
+    StatusType set_lookup_group(int groupSize);
+
+    // Scans over all live teams, O(live teams) with vectorized filters: the
+    // number of teams with a record above record, and the sum of the records
+    // of the teams with at least minJockeys riders
+    output_t<int> count_teams_above_record(int record) const;
+    output_t<long long> sum_team_records(int minJockeys) const;
+
+    // The live teams as columns, for scans of your own
+    const TeamColumns& team_columns() const { return m_columns; }
+
+    // Sets the number of threads used by bulk_load and large rehashes
+    StatusType set_worker_threads(int numThreads);
+
+    // Lazy mode defers record index maintenance after update_match and
+    // merge_teams until unite_by_record needs the index (or the bounded queue
+    // of stale teams fills up). Results are identical in both modes.
+    StatusType set_lazy_record_index(bool lazy);
+
+    // Team-relative rider queries, O(log* m) amortized like update_match:
+    // the record of the rider's current team (for the rider's share of it),
+    // and the net record of the rider's teams from matches played while the
+    // rider was on them. Records brought in by merges do not count towards
+    // the latter; matches of teams the rider's team absorbed do from the merge on.
+    output_t<int> get_jockey_team_record(int jockeyId);
+    output_t<int> get_team_record_since_joined(int jockeyId);
+
+    // Moves every union-find node into one new block, ordered by team: each
+    // team's root node is followed by its riders. Absorbed team nodes are
+    // released, as no rider points at them afterwards. External IDs do not
+    // change; the ID maps are pointed at the new nodes. Useful after bursts
+    // of merge_teams, which leave teammates scattered.
+    StatusType compact_nodes();
+
+    // Runs compact_nodes after every mergeCount successful merges (0: never)
+    StatusType set_compaction_threshold(int mergeCount);
+
+    // Bounded-latency mode caps the work of every operation. Path compression
+    // is deamortized: update_match and merge_teams also move relinkSteps
+    // absorbed team nodes one hop closer to their roots, so chains built by
+    // adversarial merge orders are flattened in the background instead of by
+    // the next find. Automatic compaction is suspended while the mode is on.
+    // 0 turns the mode off. Results are identical in both modes.
+    StatusType set_bounded_latency(int relinkSteps);
+
+    // Sizes the ID maps for numTeams teams and numJockeys riders, so that
+    // adding up to that many never rehashes in the middle of an operation.
+    // Meant for bounded-latency mode.
+    StatusType reserve_capacity(int numTeams, int numJockeys);
+
+    // Places the node arena and the ID map buckets on the given NUMA node
+    // (moving what is already allocated) and pins the worker threads to it,
+    // for a Plains owned by threads of one socket. -1 returns to first-touch
+    // placement for new memory. On single-node machines this only records
+    // the setting.
+    StatusType set_numa_node(int node);
+
+    // Writes the node count, the preferred node and the pages per node of the
+    // node arena and both ID map bucket arrays as one JSON object
+    void write_placement_report(std::ostream& os) const;
+
+    // The change feed of update_match / merge_teams / unite_by_record events,
+    // created on the first call (nullptr if that fails). Subscribe with
+    // ChangeFeed::Subscriber; without subscribers nothing is recorded.
+    ChangeFeed* change_feed();
+
+    // Approximate statistics of the update_match stream in fixed memory
+    // (MatchSketches.h), off by default. Enabling starts them empty;
+    // disabling releases them. The queries fail while they are off.
+    StatusType set_match_sketches(bool enabled);
+
+    // Distinct riders are counted per window of this many matches (0: since
+    // the sketches were enabled); the current window starts over
+    StatusType set_sketch_window(int matches);
+
+    // Estimated number of distinct riders that played in the current window,
+    // or in the last complete one
+    output_t<long long> estimate_active_jockeys(bool previousWindow);
+
+    // Estimated number of wins of a rider (never below the true count)
+    output_t<long long> estimate_jockey_wins(int jockeyId);
+
+    // The riders with the most wins, and the teams (by their ID at match
+    // time) that played the most matches, best first with their estimated
+    // counts. Up to capacity entries are written; the answer is how many.
+    output_t<int> top_winning_jockeys(int* jockeyIds, long long* wins, int capacity);
+    output_t<int> top_active_teams(int* teamIds, long long* matches, int capacity);
+
+    // The sketches themselves (nullptr while off), e.g. to merge the
+    // sketches of several shards with MatchSketches::merge
+    const MatchSketches* match_sketches() const { return m_sketches.get(); }
+
+    // Record history (RecordHistory.h), off by default: keeps the record
+    // changes of the last retentionMatches matches (0 turns it off and
+    // releases it). Enabling starts it at the current match count; changing
+    // the retention of a running history keeps what it has.
+    StatusType set_record_history(int retentionMatches);
+
+    // Successful update_match calls so far; "as of match n" means right
+    // after the n-th one (and any merges that followed it)
+    int get_match_count() const { return m_match_count; }
+
+    // Records as of match matchCount, which must lie in the history's window
+    // (O(log n) in the changes kept for the subject). Only live teams and
+    // riders have records: absorbed teams fail like in get_team_record.
+    output_t<int> get_team_record_at(int teamId, int matchCount);
+    output_t<int> get_jockey_record_at(int jockeyId, int matchCount);
+
+    // Net record of a rider over the last lastMatches matches
+    output_t<int> get_jockey_record_change(int jockeyId, int lastMatches);
+
+    // The history itself (nullptr while off), for its footprint
+    const RecordHistory* record_history() const { return m_history.get(); }
+
+    // IDs of the teams absorbed so far (they stay unavailable to add_team)
+    const IdSet& retired_team_ids() const { return m_retired_ids; }
+
+    // Writes all instrumentation counters and histograms as one JSON object
+    // (an empty one unless PLAINS_INSTRUMENT is defined)
+    void write_stats_json(std::ostream& os) const;
 };
 
 #endif // PLAINS25A2_H
\ No newline at end of file
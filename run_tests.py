@@ -1,12 +1,26 @@
 
 
 import os
+import json
+import time
 import argparse
+import hashlib
 import subprocess
 
 
-COMPILATION_FLAGS ="-std=c++11 -DNDEBUG -Wall"
+COMPILATION_FLAGS ="-std=c++11 -DNDEBUG -Wall -pthread"
 TIMEOUT = 15
+FUZZ_SOURCES = ["tools/fuzz_plains.cpp", "CommandProtocol.cpp", "CompactPlains.cpp",
+                "LeagueRegistry.cpp", "plains25a2.cpp", "ThreadPool.cpp", "SimdProbe.cpp"]
+REPLAY_SOURCES = ["tools/plains_replay.cpp", "CommandProtocol.cpp", "plains25a2.cpp",
+                  "ThreadPool.cpp", "SimdProbe.cpp"]
+
+# Scaling runs flag a regression when CPU time or peak memory grows beyond
+# these factors of the baseline (and beyond the absolute noise floors)
+TIME_TOLERANCE = 1.25
+TIME_NOISE_SECONDS = 0.05
+MEMORY_TOLERANCE = 1.15
+MEMORY_NOISE_KB = 2048
 
 
 def run_test(exe_file, test_id, tests_dir):
@@ -47,6 +61,110 @@ def run_test(exe_file, test_id, tests_dir):
             print(f"Test {test_id} Failed: Output does not match expected.")
 
 
+def run_fuzzer(code_dir, compiler_path, seconds):
+    fuzz_file = compile_tool(code_dir, compiler_path, FUZZ_SOURCES, "fuzz_plains.out")
+    if fuzz_file is None:
+        return -1
+    # The fuzzer prints a minimal repro and exits with 1 on the first mismatch
+    return subprocess.run([fuzz_file, "--seconds", str(seconds)]).returncode
+
+
+def compile_tool(code_dir, compiler_path, sources, exe_name):
+    exe_file = os.path.join(code_dir, exe_name)
+    source_files = " ".join(os.path.join(code_dir, f) for f in sources)
+    compilation_command = "{} {} -O2 -I{} -o {} {}".format(compiler_path, COMPILATION_FLAGS, code_dir, exe_file, source_files)
+    if os.system(compilation_command) != 0:
+        print(f"Compilation failed. Command executed: {compilation_command}")
+        return None
+    return exe_file
+
+
+def run_scaling_test(generator, replay, test):
+    """Pipes the generated commands through the engine; returns its measurements."""
+    start = time.perf_counter()
+    gen = subprocess.Popen([generator, test["mix"], str(test["ops"]), str(test["seed"])], stdout=subprocess.PIPE)
+    engine = subprocess.Popen([replay, "text"], stdin=gen.stdout, stdout=subprocess.PIPE)
+    gen.stdout.close()
+    digest = hashlib.sha256()
+    for chunk in iter(lambda: engine.stdout.read(1 << 20), b""):
+        digest.update(chunk)
+    # wait4 reports the engine's own CPU time and peak RSS
+    _, status, usage = os.wait4(engine.pid, 0)
+    engine.returncode = os.waitstatus_to_exitcode(status)
+    gen.wait()
+    return {
+        "wall_seconds": round(time.perf_counter() - start, 3),
+        "cpu_seconds": round(usage.ru_utime + usage.ru_stime, 3),
+        "max_rss_kb": usage.ru_maxrss,
+        "output_sha256": digest.hexdigest(),
+        "exit_code": engine.returncode,
+    }
+
+
+def compare_to_baseline(result, base):
+    """Returns the list of regressions of one scaling test (empty if none)."""
+    problems = []
+    if result["exit_code"] != 0:
+        problems.append(f"exit code {result['exit_code']}")
+    if base is None:
+        return problems
+    if result["output_sha256"] != base["output_sha256"]:
+        problems.append("output changed")
+    if result["cpu_seconds"] > base["cpu_seconds"] * TIME_TOLERANCE + TIME_NOISE_SECONDS:
+        problems.append(f"time {result['cpu_seconds']:.2f}s vs {base['cpu_seconds']:.2f}s")
+    if result["max_rss_kb"] > base["max_rss_kb"] * MEMORY_TOLERANCE + MEMORY_NOISE_KB:
+        problems.append(f"memory {result['max_rss_kb']} KB vs {base['max_rss_kb']} KB")
+    return problems
+
+
+def run_scaling(args):
+    corpus_dir = os.path.join(args.tests_dir, "scaling")
+    baseline_file = os.path.join(corpus_dir, "baseline.json")
+    with open(os.path.join(corpus_dir, "corpus.json"), "r") as f:
+        corpus = json.load(f)["tests"]
+    baseline = {}
+    if os.path.isfile(baseline_file):
+        with open(baseline_file, "r") as f:
+            baseline = json.load(f)
+
+    generator = compile_tool(args.code_dir, args.compiler_path, ["tools/gen_corpus.cpp"], "gen_corpus.out")
+    replay = compile_tool(args.code_dir, args.compiler_path, REPLAY_SOURCES, "plains_replay.out")
+    if generator is None or replay is None:
+        return -1
+
+    print(f"{'test':<16}{'ops':>11}{'cpu s':>9}{'ns/op':>8}{'x prev':>8}{'RSS MB':>9}  verdict")
+    failed = 0
+    previous = {}
+    for test in corpus:
+        if test["ops"] > args.max_ops:
+            continue
+        result = run_scaling_test(generator, replay, test)
+        ns_per_op = result["cpu_seconds"] * 1e9 / test["ops"]
+        # ns/op relative to the previous size of the same mix: stays near 1
+        # while the operations scale as (almost) constant amortized time
+        growth = f"{ns_per_op / previous[test['mix']]:.2f}" if previous.get(test["mix"]) else "-"
+        previous[test["mix"]] = ns_per_op
+        problems = compare_to_baseline(result, baseline.get(test["name"]))
+        if problems:
+            verdict = "REGRESSION: " + ", ".join(problems)
+            failed += 1
+        else:
+            verdict = "ok" if test["name"] in baseline else "ok (no baseline)"
+        print(f"{test['name']:<16}{test['ops']:>11}{result['cpu_seconds']:>9.2f}{ns_per_op:>8.0f}{growth:>8}"
+              f"{result['max_rss_kb'] / 1024:>9.1f}  {verdict}", flush=True)
+        if args.update_baseline and result["exit_code"] == 0:
+            result.pop("exit_code")
+            baseline[test["name"]] = result
+
+    if args.update_baseline:
+        with open(baseline_file, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print(f"Baseline written to {baseline_file}")
+        return 0
+    return 1 if failed else 0
+
+
 def main():
     parser = argparse.ArgumentParser(description="Generate Tests.")
     parser.add_argument("--tests_dir", type=str, default="./tests/", help="Path to the dir with the tests to run (default: './tests/').")
@@ -61,8 +179,22 @@ def main():
         help="List of test IDs to run (default: run all tests).", 
         default=None
     )
+    parser.add_argument("--fuzz", type=float, nargs="?", const=10, default=None, metavar="SECONDS",
+                        help="Run the differential fuzzer for SECONDS (default: 10) instead of the tests.")
+    parser.add_argument("--scaling", action="store_true",
+                        help="Run the generated scaling corpus (tests/scaling) and compare time and memory to the baseline.")
+    parser.add_argument("--max_ops", type=int, default=10 ** 7,
+                        help="Skip scaling tests with more operations (default: 10^7; the corpus goes up to 10^8).")
+    parser.add_argument("--update_baseline", action="store_true",
+                        help="With --scaling, store the measured results as the new baseline.")
     args = parser.parse_args()
 
+    if args.scaling:
+        return run_scaling(args)
+
+    if args.fuzz is not None:
+        return run_fuzzer(args.code_dir, args.compiler_path, args.fuzz)
+
     source_files = os.path.join(args.code_dir, "*.cpp")
     exe_file = os.path.join(args.code_dir, "main.out")
     compilation_command = "g++ {} -o {} {}".format(COMPILATION_FLAGS, exe_file, source_files)
@@ -92,4 +224,4 @@ def main():
 
 
 if __name__ == "__main__":
-    main()
+    exit(main())
@@ -0,0 +1,86 @@
+// Per-lookup cost of the batched Plains operations by group size.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/bench_batch.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o bench_batch
+// Usage: ./bench_batch [jockeys] [batch]
+//
+// Loads jockeys riders (IDs scattered over 1..INT_MAX) into jockeys / 16
+// teams, far more than the caches hold, then runs batches of random riders
+// through get_jockey_records and update_matches with every group size. Group
+// size 1 is the plain loop; the others prefetch each group stage by stage.
+// Prints nanoseconds per lookup and a checksum that must not depend on the
+// group size.
+
+#include "plains25a2.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+// Distinct IDs in 1..INT_MAX: multiplying by an odd constant permutes 2^31
+static int scattered_id(int i, unsigned int multiplier) {
+    int id = static_cast<int>((static_cast<unsigned int>(i) * multiplier) & 0x7FFFFFFFu);
+    return id ? id : 0x7FFFFFFF;
+}
+
+static unsigned int next_random(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int jockeys = argc > 1 ? atoi(argv[1]) : 4000000;
+    int batch = argc > 2 ? atoi(argv[2]) : 1000000;
+    if (jockeys < 2 || batch <= 0) {
+        fprintf(stderr, "Usage: %s [jockeys >= 2] [batch]\n", argv[0]);
+        return 2;
+    }
+    std::unique_ptr<Plains> plains(new Plains());
+    int teams = jockeys / 16 + 1;
+    plains->reserve_capacity(teams, jockeys);
+    for (int i = 1; i <= teams; ++i) {
+        plains->add_team(scattered_id(i, 0x9E3779B1u));
+    }
+    for (int i = 1; i <= jockeys; ++i) {
+        plains->add_jockey(scattered_id(i, 0x85EBCA77u), scattered_id(1 + i % teams, 0x9E3779B1u));
+    }
+
+    std::unique_ptr<int[]> winners(new int[batch]);
+    std::unique_ptr<int[]> losers(new int[batch]);
+    std::unique_ptr<int[]> records(new int[batch]);
+    std::unique_ptr<StatusType[]> statuses(new StatusType[batch]);
+    unsigned int state = 2463534242u;
+    for (int i = 0; i < batch; ++i) {
+        winners[i] = scattered_id(1 + next_random(state) % jockeys, 0x85EBCA77u);
+        losers[i] = scattered_id(1 + next_random(state) % jockeys, 0x85EBCA77u);
+    }
+
+    static const int GROUPS[] = {1, 4, 8, 16, 32};
+    printf("%-6s %14s %14s %12s\n", "group", "lookup ns", "match ns", "checksum");
+    for (int group : GROUPS) {
+        plains->set_lookup_group(group);
+        auto start = std::chrono::steady_clock::now();
+        plains->get_jockey_records(winners.get(), batch, statuses.get(), records.get());
+        double lookup = seconds_since(start);
+        long long checksum = 0;
+        for (int i = 0; i < batch; ++i) {
+            checksum += records[i];
+        }
+
+        // Every match is played once forwards and once backwards, so the
+        // records are back to where they were for the next group size
+        start = std::chrono::steady_clock::now();
+        plains->update_matches(winners.get(), losers.get(), batch, statuses.get());
+        plains->update_matches(losers.get(), winners.get(), batch, statuses.get());
+        double match = seconds_since(start) / 2;
+        for (int i = 0; i < batch; ++i) {
+            checksum += static_cast<int>(statuses[i]);
+        }
+        printf("%-6d %14.1f %14.1f %12lld\n", group, lookup * 1e9 / batch, match * 1e9 / batch, checksum);
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+// Team churn: short-lived teams that are added and merged away.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/bench_churn.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o bench_churn
+// Usage: ./bench_churn [live teams] [churned teams]
+//
+// Keeps a league of live teams with 16 riders each and, for every churned
+// team, adds a fresh team (every other one with a new rider), plays a match
+// and merges it with a random live team. Prints ns per churn cycle, the ns of
+// add_team on retired IDs (FAILURE), the size of the team map and of the
+// retired-ID set, and the peak resident growth per churned team.
+
+#include "plains25a2.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <sys/resource.h>
+
+static long max_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static unsigned int next_random(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+int main(int argc, char** argv) {
+    int liveTeams = argc > 1 ? atoi(argv[1]) : 10000;
+    int churned = argc > 2 ? atoi(argv[2]) : 2000000;
+    if (liveTeams <= 0 || churned <= 0) {
+        fprintf(stderr, "Usage: %s [live teams] [churned teams]\n", argv[0]);
+        return 2;
+    }
+    std::unique_ptr<Plains> plains(new Plains());
+    std::unique_ptr<int[]> live(new int[liveTeams]);
+    int nextTeam = 1;
+    int nextJockey = 1;
+    for (int i = 0; i < liveTeams; ++i) {
+        live[i] = nextTeam++;
+        plains->add_team(live[i]);
+        for (int j = 0; j < 16; ++j) {
+            plains->add_jockey(nextJockey++, live[i]);
+        }
+    }
+    long before = max_rss_kb();
+    unsigned int state = 2463534242u;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < churned; ++i) {
+        int team = nextTeam++;
+        plains->add_team(team);
+        if (i % 2 == 0) {
+            plains->add_jockey(nextJockey, team);
+            int rival = 1 + static_cast<int>(next_random(state) % (16 * liveTeams));
+            if (next_random(state) & 1) {
+                plains->update_match(nextJockey, rival);
+            } else {
+                plains->update_match(rival, nextJockey);
+            }
+            nextJockey++;
+        }
+        int slot = static_cast<int>(next_random(state) % liveTeams);
+        plains->merge_teams(live[slot], team);
+        if (plains->get_team_record(team).status() == StatusType::SUCCESS) {
+            live[slot] = team;
+        }
+    }
+    double churnNs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / churned;
+    long growth = max_rss_kb() - before;
+
+    const int probes = 1000000;
+    int failures = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < probes; ++i) {
+        int retired = liveTeams + 1 + static_cast<int>(next_random(state) % churned);
+        failures += plains->add_team(retired) == StatusType::FAILURE;
+    }
+    double probeNs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / probes;
+
+    printf("churn cycle: %.1f ns, add_team on a used ID: %.1f ns (%d of %d failed)\n", churnNs, probeNs,
+           failures, probes);
+    printf("team map: %d live teams, retired IDs: %d in %lld bytes (%.2f bytes per ID)\n",
+           plains->team_columns().get_size(), plains->retired_team_ids().get_size(),
+           plains->retired_team_ids().memory_bytes(),
+           static_cast<double>(plains->retired_team_ids().memory_bytes()) / plains->retired_team_ids().get_size());
+    printf("resident growth: %.1f bytes per churned team\n", growth * 1024.0 / churned);
+    return 0;
+}
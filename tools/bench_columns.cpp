@@ -0,0 +1,81 @@
+// Full-league team scans through the team columns versus per-team lookups.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/bench_columns.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o bench_columns
+// Usage: ./bench_columns [teams]
+//
+// Adds teams teams with 4 riders each, plays one random match per rider and
+// merges a quarter of the teams. Then it counts the teams with a positive
+// record twice: with count_teams_above_record, and by walking every team ID
+// through get_team_record as a caller without the columns has to. It also
+// times sum_team_records(6), which has no lookup equivalent (team sizes are
+// not exposed otherwise). Prints ns per team.
+
+#include "plains25a2.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int teams = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (teams < 2 || teams > 100000000) {
+        fprintf(stderr, "Usage: %s [teams]\n", argv[0]);
+        return 2;
+    }
+    const int RIDERS = 4;
+    const int ROUNDS = 20;
+    std::unique_ptr<Plains> plains(new Plains());
+    int jockeys = teams * RIDERS;
+    plains->reserve_capacity(teams, jockeys);
+    for (int i = 1; i <= teams; ++i) {
+        plains->add_team(i);
+    }
+    for (int i = 1; i <= jockeys; ++i) {
+        plains->add_jockey(i, 1 + (i - 1) / RIDERS);
+    }
+    unsigned int state = 2463534242u;
+    for (int i = 1; i <= jockeys; ++i) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        plains->update_match(i, 1 + static_cast<int>(state % static_cast<unsigned int>(jockeys)));
+    }
+    for (int i = 1; i + 3 <= teams; i += 8) {
+        plains->merge_teams(i, i + 1);
+        plains->merge_teams(i + 2, i + 3);
+    }
+
+    long long positive = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        positive += plains->count_teams_above_record(0).ans();
+    }
+    double count = seconds_since(start) / ROUNDS;
+
+    long long sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        sum += plains->sum_team_records(6).ans();
+    }
+    double summed = seconds_since(start) / ROUNDS;
+
+    long long lookupPositive = 0;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (int i = 1; i <= teams; ++i) {
+            output_t<int> record = plains->get_team_record(i);
+            lookupPositive += record.status() == StatusType::SUCCESS && record.ans() > 0;
+        }
+    }
+    double lookups = seconds_since(start) / ROUNDS;
+
+    printf("%d live teams of %d\n", plains->team_columns().get_size(), teams);
+    printf("count_teams_above_record(0)  %8.2f ns/team  %lld teams\n", count * 1e9 / teams, positive / ROUNDS);
+    printf("sum_team_records(6)          %8.2f ns/team  %lld\n", summed * 1e9 / teams, sum / ROUNDS);
+    printf("get_team_record per ID       %8.2f ns/team  %lld teams\n", lookups * 1e9 / teams,
+           lookupPositive / ROUNDS);
+    return positive == lookupPositive ? 0 : 1;
+}
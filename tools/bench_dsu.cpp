@@ -0,0 +1,140 @@
+// Benchmark of the Dsu.h policy combinations.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -I. tools/bench_dsu.cpp -o bench_dsu
+// Usage: ./bench_dsu [elements] [operations]
+//
+// Every configuration runs the same seeded workload: operations random
+// unions interleaved with twice as many random finds over elements. The sum
+// of the found roots' payloads is printed as a checksum, so all rows that
+// aggregate must agree.
+
+#include "Dsu.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+// Node for PointerStorage, the layout Plains uses
+struct BenchNode {
+    BenchNode* m_parent;
+    int m_size;
+    long long m_payload;
+};
+
+// PointerStorage with the payload SumAggregate needs
+struct BenchPointerStorage : PointerStorage<BenchNode> {
+    long long& payload(BenchNode* h) { return h->m_payload; }
+};
+
+static unsigned long long next_random(unsigned long long& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Maximum depth of any element, walking parents without compressing
+template<typename Forest, typename HandleOf>
+static int max_depth(Forest& forest, int elements, HandleOf handle_of) {
+    int deepest = 0;
+    for (int i = 0; i < elements; ++i) {
+        auto h = handle_of(i);
+        int depth = 0;
+        while (forest.storage().parent(h) != h) {
+            h = forest.storage().parent(h);
+            depth++;
+        }
+        deepest = depth > deepest ? depth : deepest;
+    }
+    return deepest;
+}
+
+template<typename Forest, typename HandleOf>
+static void run(const char* name, Forest& forest, int elements, int operations, HandleOf handle_of) {
+    for (int i = 0; i < elements; ++i) {
+        forest.make_set(handle_of(i));
+        forest.storage().payload(handle_of(i)) = i;
+    }
+    unsigned long long state = 0x2545F4914F6CDD1Dull;
+    long long checksum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int op = 0; op < operations; ++op) {
+        int a = static_cast<int>(next_random(state) % elements);
+        int b = static_cast<int>(next_random(state) % elements);
+        forest.unite(handle_of(a), handle_of(b));
+        for (int find = 0; find < 2; ++find) {
+            int c = static_cast<int>(next_random(state) % elements);
+            checksum += forest.storage().payload(forest.find(handle_of(c)));
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-34s %8.1f ns/op   max depth %3d   checksum %lld\n", name,
+           seconds * 1e9 / (3.0 * operations), max_depth(forest, elements, handle_of), checksum);
+}
+
+template<typename Linking, typename Compression>
+static void run_array(const char* name, int elements, int operations) {
+    std::unique_ptr<Dsu<ArrayStorage<long long>, Linking, Compression, SumAggregate>> forest(
+        new Dsu<ArrayStorage<long long>, Linking, Compression, SumAggregate>());
+    forest->storage().reserve(elements);
+    run(name, *forest, elements, operations, [](int i) { return i; });
+}
+
+template<typename Linking, typename Compression>
+static void run_pointer(const char* name, int elements, int operations) {
+    std::unique_ptr<BenchNode[]> nodes(new BenchNode[elements]);
+    BenchNode* base = nodes.get();
+    Dsu<BenchPointerStorage, Linking, Compression, SumAggregate> forest;
+    run(name, forest, elements, operations, [base](int i) { return base + i; });
+}
+
+// Rollback: every round links a batch, then undoes it again
+static void run_rollback(int elements, int operations) {
+    Dsu<ArrayStorage<long long>, LinkBySize, NoCompression, SumAggregate> forest;
+    forest.storage().reserve(elements);
+    for (int i = 0; i < elements; ++i) {
+        forest.make_set(i);
+        forest.storage().payload(i) = i;
+    }
+    unsigned long long state = 0x2545F4914F6CDD1Dull;
+    const int BATCH = 1024;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int op = 0; op < operations; op += BATCH) {
+        int checkpoint = forest.checkpoint();
+        for (int i = 0; i < BATCH; ++i) {
+            int a = static_cast<int>(next_random(state) % elements);
+            int b = static_cast<int>(next_random(state) % elements);
+            forest.unite(a, b);
+        }
+        forest.rollback(checkpoint);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int sets = 0;
+    for (int i = 0; i < elements; ++i) {
+        sets += forest.is_root(i);
+    }
+    printf("%-34s %8.1f ns/op   sets after rollback %d of %d\n", "array   size    none, rollback",
+           seconds * 1e9 / operations, sets, elements);
+}
+
+int main(int argc, char** argv) {
+    int elements = argc > 1 ? atoi(argv[1]) : 1000000;
+    int operations = argc > 2 ? atoi(argv[2]) : 2000000;
+    if (elements <= 0 || operations <= 0) {
+        fprintf(stderr, "Usage: %s [elements] [operations]\n", argv[0]);
+        return 2;
+    }
+    printf("%d elements, %d unions and %d finds\n", elements, operations, 2 * operations);
+    run_array<LinkBySize, FullCompression>("array   size    full", elements, operations);
+    run_array<LinkBySize, PathHalving>("array   size    halving", elements, operations);
+    run_array<LinkBySize, PathSplitting>("array   size    splitting", elements, operations);
+    run_array<LinkBySize, NoCompression>("array   size    none", elements, operations);
+    run_array<LinkByRank, FullCompression>("array   rank    full", elements, operations);
+    run_array<LinkByRank, PathHalving>("array   rank    halving", elements, operations);
+    run_array<LinkRandomized, PathHalving>("array   random  halving", elements, operations);
+    run_array<LinkRandomized, FullCompression>("array   random  full", elements, operations);
+    run_pointer<LinkBySize, FullCompression>("pointer size    full", elements, operations);
+    run_pointer<LinkBySize, PathHalving>("pointer size    halving", elements, operations);
+    run_pointer<LinkByRank, PathSplitting>("pointer rank    splitting", elements, operations);
+    run_rollback(elements, operations);
+    return 0;
+}
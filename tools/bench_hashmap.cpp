@@ -0,0 +1,117 @@
+// Lookup benchmark for the HashMap policies.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/bench_hashmap.cpp ThreadPool.cpp -o bench_hashmap
+// Usage: ./bench_hashmap [entries] [lookups]
+
+#include "HashMap.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// The indexing HashMap used before the policies existed: a signed double
+// modulo into a table that starts at 10007 buckets and doubles
+struct LegacyModuloGrowth {
+    static int initial_capacity() { return 10007; }
+    static int next_capacity(int capacity) { return capacity * 2; }
+    static int capacity_for(long long needed) {
+        long long capacity = initial_capacity();
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        return static_cast<int>(capacity);
+    }
+    static int index(std::size_t hash, int capacity) {
+        int key = static_cast<int>(hash);
+        return ((key % capacity) + capacity) % capacity;
+    }
+};
+
+struct Payload {
+    int m_value;
+};
+
+static unsigned int next_random(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+template<typename Map>
+static double bench_get_value(const char* name, const int* keys, int entries,
+                              const int* queries, int lookups, Payload* payloads, double baseline)
+{
+    Map map;
+    for (int i = 0; i < entries; ++i) {
+        map.insert(keys[i], payloads + i);
+    }
+    long long checksum = 0;
+    // One warm-up pass, then the timed pass
+    for (int pass = 0; pass < 2; ++pass) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < lookups; ++i) {
+            Payload* value = map.get_value(queries[i]);
+            checksum += value ? value->m_value : 0;
+        }
+        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+        if (pass == 1) {
+            double ns = std::chrono::duration<double, std::nano>(elapsed).count() / lookups;
+            std::printf("%-34s %8.2f ns/lookup  %5.2fx  (checksum %lld)\n",
+                        name, ns, baseline > 0 ? baseline / ns : 1.0, checksum);
+            return ns;
+        }
+    }
+    return 0;
+}
+
+static void run_suite(const char* title, const int* keys, int entries, const int* queries,
+                      int lookups, Payload* payloads)
+{
+    std::printf("== %s: %d entries, %d lookups ==\n", title, entries, lookups);
+    double legacy = bench_get_value<HashMap<Payload, int, IdentityHash, LegacyModuloGrowth> >(
+        "legacy (double %, doubling)", keys, entries, queries, lookups, payloads, 0);
+    bench_get_value<HashMap<Payload, int, IdentityHash, PrimeGrowth> >(
+        "IdentityHash + PrimeGrowth", keys, entries, queries, lookups, payloads, legacy);
+    bench_get_value<HashMap<Payload, int, IdentityHash, PowerOfTwoGrowth> >(
+        "IdentityHash + PowerOfTwoGrowth", keys, entries, queries, lookups, payloads, legacy);
+    bench_get_value<HashMap<Payload, int, FibonacciHash, PowerOfTwoGrowth> >(
+        "FibonacciHash + PowerOfTwoGrowth", keys, entries, queries, lookups, payloads, legacy);
+    bench_get_value<HashMap<Payload, int, FibonacciHash, PowerOfTwoGrowth, 1, 2> >(
+        "Fibonacci + PowerOfTwo, load 1/2", keys, entries, queries, lookups, payloads, legacy);
+}
+
+int main(int argc, char** argv)
+{
+    int entries = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    int lookups = argc > 2 ? std::atoi(argv[2]) : 10000000;
+    if (entries <= 0 || lookups <= 0) {
+        std::fprintf(stderr, "usage: %s [entries] [lookups]\n", argv[0]);
+        return 1;
+    }
+
+    int* keys = new int[entries];
+    int* queries = new int[lookups];
+    Payload* payloads = new Payload[entries];
+    unsigned int state = 2463534242u;
+
+    for (int i = 0; i < entries; ++i) {
+        keys[i] = i + 1;
+        payloads[i].m_value = i;
+    }
+    for (int i = 0; i < lookups; ++i) {
+        queries[i] = keys[next_random(state) % entries];
+    }
+    run_suite("sequential IDs", keys, entries, queries, lookups, payloads);
+
+    for (int i = 0; i < entries; ++i) {
+        keys[i] = static_cast<int>(next_random(state) & 0x7fffffff) | 1;
+    }
+    for (int i = 0; i < lookups; ++i) {
+        queries[i] = keys[next_random(state) % entries];
+    }
+    run_suite("random IDs", keys, entries, queries, lookups, payloads);
+
+    delete[] payloads;
+    delete[] queries;
+    delete[] keys;
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Cost and footprint of the record history.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/bench_history.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o bench_history
+// Usage: ./bench_history [jockeys] [matches] [retention]
+//
+// Plays the same random match stream twice, with the history off and on
+// (keeping the last retention matches), and prints ns per match for both,
+// the history's bytes per kept match, and the ns of point-in-time queries
+// for random riders at random points of the window.
+
+#include "plains25a2.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+static unsigned int next_random(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static double play(Plains& plains, int jockeys, int matches) {
+    unsigned int state = 2463534242u;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < matches; ++i) {
+        int winner = 1 + static_cast<int>(next_random(state) % jockeys);
+        int loser = 1 + static_cast<int>(next_random(state) % jockeys);
+        plains.update_match(winner, loser);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / matches;
+}
+
+static void load(Plains& plains, int jockeys) {
+    int teams = jockeys / 16 + 1;
+    for (int i = 1; i <= teams; ++i) {
+        plains.add_team(i);
+    }
+    for (int i = 1; i <= jockeys; ++i) {
+        plains.add_jockey(i, 1 + i % teams);
+    }
+}
+
+int main(int argc, char** argv) {
+    int jockeys = argc > 1 ? atoi(argv[1]) : 100000;
+    int matches = argc > 2 ? atoi(argv[2]) : 4000000;
+    int retention = argc > 3 ? atoi(argv[3]) : 1000000;
+    if (jockeys <= 0 || matches <= 0 || retention <= 0) {
+        fprintf(stderr, "Usage: %s [jockeys] [matches] [retention]\n", argv[0]);
+        return 2;
+    }
+    std::unique_ptr<Plains> off(new Plains());
+    load(*off, jockeys);
+    double offNs = play(*off, jockeys, matches);
+    off.reset();
+
+    std::unique_ptr<Plains> on(new Plains());
+    load(*on, jockeys);
+    on->set_record_history(retention);
+    double onNs = play(*on, jockeys, matches);
+    printf("update_match: %.1f ns without history, %.1f ns with\n", offNs, onNs);
+
+    const RecordHistory* history = on->record_history();
+    int count = on->get_match_count();
+    int kept = count - history->get_window_start();
+    printf("history: %lld bytes in %d live blocks for %d matches, %.1f bytes per match\n",
+           history->memory_bytes(), history->get_live_blocks(), kept,
+           static_cast<double>(history->memory_bytes()) / kept);
+
+    unsigned int state = 88172645u;
+    const int queries = 1000000;
+    long long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < queries; ++i) {
+        int jockey = 1 + static_cast<int>(next_random(state) % jockeys);
+        int at = count - static_cast<int>(next_random(state) % (kept + 1));
+        checksum += on->get_jockey_record_at(jockey, at).ans();
+    }
+    double queryNs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / queries;
+    printf("get_jockey_record_at: %.1f ns (checksum %lld)\n", queryNs, checksum);
+    return 0;
+}
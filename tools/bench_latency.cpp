@@ -0,0 +1,119 @@
+// Per-operation latency of Plains under an adversarial merge order.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/bench_latency.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o bench_latency
+// Usage: ./bench_latency [log2 teams] [relink steps]
+//
+// 2^k teams with one rider each are split into two halves, and each half is
+// merged pairwise in rounds of equal-sized teams. That is the order that
+// makes union by size build its deepest trees (binomial trees): the last
+// rider of a half ends up k hops from its root, and since merge_teams never
+// runs a find, the chains are first paid by update_match. Every rider then
+// plays the rider at the same position in the other half, deepest first.
+//
+// Each phase is timed per operation in three modes: the defaults, the
+// defaults after reserve_capacity, and bounded-latency mode (reserved, with
+// the given relink steps). Latencies are in nanoseconds.
+
+#include "plains25a2.h"
+#include "RadixSort.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+// Latencies of one phase
+class Samples {
+private:
+    std::unique_ptr<unsigned int[]> m_values;
+    int m_count;
+    int m_capacity;
+
+public:
+    explicit Samples(int capacity) : m_values(new unsigned int[capacity]), m_count(0), m_capacity(capacity) {}
+
+    void add(std::chrono::steady_clock::time_point start) {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        if (m_count < m_capacity) {
+            m_values[m_count++] = ns > 0xFFFFFFFFll ? 0xFFFFFFFFu : static_cast<unsigned int>(ns);
+        }
+    }
+
+    void report(const char* mode, const char* phase) {
+        if (m_count == 0) {
+            return;
+        }
+        std::unique_ptr<unsigned int[]> tmpKeys(new unsigned int[m_count]);
+        std::unique_ptr<int[]> rows(new int[m_count]);
+        std::unique_ptr<int[]> tmpRows(new int[m_count]);
+        double total = 0;
+        for (int i = 0; i < m_count; ++i) {
+            rows[i] = i;
+            total += m_values[i];
+        }
+        radix_sort_pairs(m_values.get(), rows.get(), m_count, tmpKeys.get(), tmpRows.get());
+        printf("%-9s %-8s %9d %9.0f %9u %9u %10u\n", mode, phase, m_count, total / m_count,
+               m_values[static_cast<int>(m_count * 0.99)], m_values[static_cast<int>(m_count * 0.999)],
+               m_values[m_count - 1]);
+        m_count = 0;
+    }
+};
+
+static void run(const char* mode, int log2Teams, bool reserve, int relinkSteps) {
+    const int teams = 1 << log2Teams;
+    const int half = teams / 2;
+    std::unique_ptr<Plains> plains(new Plains());
+    if (reserve) {
+        plains->reserve_capacity(teams, teams);
+    }
+    plains->set_bounded_latency(relinkSteps);
+    Samples samples(2 * teams);
+    std::chrono::steady_clock::time_point start;
+
+    // Team i and rider i, for i = 1..teams
+    for (int i = 1; i <= teams; ++i) {
+        start = std::chrono::steady_clock::now();
+        plains->add_team(i);
+        samples.add(start);
+    }
+    for (int i = 1; i <= teams; ++i) {
+        start = std::chrono::steady_clock::now();
+        plains->add_jockey(i, i);
+        samples.add(start);
+    }
+    samples.report(mode, "load");
+
+    // Round r merges team blocks of 2^r within each half. All records are 0,
+    // so the first team keeps its ID and, on equal sizes, its root.
+    for (int width = 1; width < half; width *= 2) {
+        for (int base = 0; base < teams; base += half) {
+            for (int first = base + 1; first + width <= base + half; first += 2 * width) {
+                start = std::chrono::steady_clock::now();
+                plains->merge_teams(first, first + width);
+                samples.add(start);
+            }
+        }
+    }
+    samples.report(mode, "merges");
+
+    for (int i = half; i >= 1; --i) {
+        start = std::chrono::steady_clock::now();
+        plains->update_match(i, i + half);
+        samples.add(start);
+    }
+    samples.report(mode, "matches");
+}
+
+int main(int argc, char** argv) {
+    int log2Teams = argc > 1 ? atoi(argv[1]) : 20;
+    int relinkSteps = argc > 2 ? atoi(argv[2]) : 8;
+    if (log2Teams < 2 || log2Teams > 28 || relinkSteps <= 0) {
+        fprintf(stderr, "Usage: %s [log2 teams (2..28)] [relink steps]\n", argv[0]);
+        return 2;
+    }
+    printf("2^%d teams, binomial merges, %d relink steps in bounded mode\n", log2Teams, relinkSteps);
+    printf("%-9s %-8s %9s %9s %9s %9s %10s\n", "mode", "phase", "ops", "mean", "p99", "p99.9", "max");
+    run("default", log2Teams, false, 0);
+    run("reserved", log2Teams, true, 0);
+    run("bounded", log2Teams, true, relinkSteps);
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Resident memory per rider of Plains and CompactPlains.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/bench_memory.cpp CompactPlains.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o bench_memory
+// Usage: ./bench_memory <plains|compact|compact-reserved> [jockeys]
+//
+// Loads the given number of riders into jockeys / 16 teams through
+// add_team / add_jockey, then merges half of the teams, and prints the growth
+// of the peak resident set divided by the number of riders (team costs
+// included). IDs are scattered over 1..INT_MAX. One engine per run, since
+// the peak resident set never shrinks.
+
+#include "CompactPlains.h"
+#include "plains25a2.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/resource.h>
+
+static long max_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Distinct IDs in 1..INT_MAX: multiplying by an odd constant permutes 2^31
+static int scattered_id(int i, unsigned int multiplier) {
+    int id = static_cast<int>((static_cast<unsigned int>(i) * multiplier) & 0x7FFFFFFFu);
+    return id ? id : 0x7FFFFFFF;
+}
+
+template<typename Engine>
+static void load(Engine& engine, int jockeys) {
+    int teams = jockeys / 16 + 1;
+    for (int i = 1; i <= teams; ++i) {
+        engine.add_team(scattered_id(i, 0x9E3779B1u));
+    }
+    for (int i = 1; i <= jockeys; ++i) {
+        engine.add_jockey(scattered_id(i, 0x85EBCA77u), scattered_id(1 + i % teams, 0x9E3779B1u));
+    }
+    for (int i = 1; i + 1 <= teams; i += 4) {
+        engine.merge_teams(scattered_id(i, 0x9E3779B1u), scattered_id(i + 1, 0x9E3779B1u));
+        engine.merge_teams(scattered_id(i + 2, 0x9E3779B1u), scattered_id(i + 3, 0x9E3779B1u));
+    }
+}
+
+int main(int argc, char** argv) {
+    int jockeys = argc > 2 ? atoi(argv[2]) : 10000000;
+    if (argc < 2 || jockeys <= 0) {
+        fprintf(stderr, "Usage: %s <plains|compact|compact-reserved> [jockeys]\n", argv[0]);
+        return 2;
+    }
+    long before = max_rss_kb();
+    long long reported = -1;
+    if (strcmp(argv[1], "plains") == 0) {
+        Plains* plains = new Plains();
+        load(*plains, jockeys);
+    } else if (strcmp(argv[1], "compact") == 0 || strcmp(argv[1], "compact-reserved") == 0) {
+        CompactPlains* plains = new CompactPlains();
+        if (argv[1][7] == '-') {
+            plains->reserve(jockeys / 16 + 1, jockeys);
+        }
+        load(*plains, jockeys);
+        reported = plains->memory_bytes();
+    } else {
+        fprintf(stderr, "Unknown engine %s\n", argv[1]);
+        return 2;
+    }
+    // The engines are leaked on purpose: only the peak matters
+    double perJockey = (max_rss_kb() - before) * 1024.0 / jockeys;
+    printf("%-17s %11d jockeys  %6.1f bytes/jockey resident", argv[1], jockeys, perJockey);
+    if (reported >= 0) {
+        printf("  (%.1f in tables)", static_cast<double>(reported) / jockeys);
+    }
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Cost and accuracy of the match stream sketches.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/bench_sketches.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o bench_sketches
+// Usage: ./bench_sketches [jockeys] [matches]
+//
+// Plays the same skewed match stream (a tenth of the matches are won by 20
+// star riders, the rest are random) twice, with the sketches off and on, and
+// prints ns per match for both. Then compares the sketch answers with exact
+// counts kept by the tool: distinct riders, the top winners and their wins.
+
+#include "plains25a2.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+static unsigned int next_random(unsigned int& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static double play(Plains& plains, int jockeys, int matches, int* wins, bool* played) {
+    unsigned int state = 2463534242u;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < matches; ++i) {
+        int winner = 1 + static_cast<int>(next_random(state) % jockeys);
+        if (i % 10 == 0) {
+            winner = 1 + static_cast<int>(next_random(state) % 20) * (jockeys / 20);
+        }
+        int loser = 1 + static_cast<int>(next_random(state) % jockeys);
+        if (plains.update_match(winner, loser) == StatusType::SUCCESS && wins) {
+            wins[winner]++;
+            played[winner] = true;
+            played[loser] = true;
+        }
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / matches;
+}
+
+static void load(Plains& plains, int jockeys) {
+    int teams = jockeys / 16 + 1;
+    for (int i = 1; i <= teams; ++i) {
+        plains.add_team(i);
+    }
+    for (int i = 1; i <= jockeys; ++i) {
+        plains.add_jockey(i, 1 + i % teams);
+    }
+}
+
+int main(int argc, char** argv) {
+    int jockeys = argc > 1 ? atoi(argv[1]) : 1000000;
+    int matches = argc > 2 ? atoi(argv[2]) : 4000000;
+    if (jockeys < 20 || matches <= 0) {
+        fprintf(stderr, "Usage: %s [jockeys >= 20] [matches]\n", argv[0]);
+        return 2;
+    }
+    std::unique_ptr<Plains> off(new Plains());
+    load(*off, jockeys);
+    double offNs = play(*off, jockeys, matches, nullptr, nullptr);
+    off.reset();
+
+    std::unique_ptr<int[]> wins(new int[jockeys + 1]());
+    std::unique_ptr<bool[]> played(new bool[jockeys + 1]());
+    std::unique_ptr<Plains> on(new Plains());
+    load(*on, jockeys);
+    on->set_match_sketches(true);
+    double onNs = play(*on, jockeys, matches, wins.get(), played.get());
+    printf("update_match: %.1f ns without sketches, %.1f ns with\n", offNs, onNs);
+
+    long long distinct = 0;
+    for (int i = 1; i <= jockeys; ++i) {
+        distinct += played[i];
+    }
+    long long estimate = on->estimate_active_jockeys(false).ans();
+    printf("distinct riders: %lld exact, %lld estimated (%+.2f%%)\n", distinct, estimate,
+           100.0 * (estimate - distinct) / distinct);
+
+    int ids[10];
+    long long counts[10];
+    int listed = on->top_winning_jockeys(ids, counts, 10).ans();
+    printf("top winners (estimated / exact wins):\n");
+    for (int i = 0; i < listed; ++i) {
+        printf("  %9d %8lld / %d\n", ids[i], counts[i], wins[ids[i]]);
+    }
+    return 0;
+}
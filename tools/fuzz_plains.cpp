@@ -0,0 +1,1268 @@
+// Differential fuzzer and replay validator for the Plains engines.
+// Random command sequences run against a simple reference model and every
+// engine variant; every StatusType and answer is compared, and a failing
+// sequence is shrunk to a minimal repro printed in main.cpp's input format.
+//
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/fuzz_plains.cpp CommandProtocol.cpp CompactPlains.cpp LeagueRegistry.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o fuzz_plains
+// Usage:
+//   ./fuzz_plains [--seconds S] [--cases N] [--ops L] [--seed X]   fuzz (default: 10 seconds)
+//   ./fuzz_plains --replay commands.txt                            run one file through all engines
+// Or: python3 run_tests.py --fuzz [seconds]
+
+#include "CommandProtocol.h"
+#include "CompactPlains.h"
+#include "LeagueRegistry.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+static const char* const OPCODE_NAMES[] = {
+    "", "add_team", "add_jockey", "update_match", "merge_teams",
+    "unite_by_record", "get_jockey_record", "get_team_record"
+};
+static const int OPCODE_ARITY[] = {0, 1, 2, 2, 2, 1, 1, 1};
+
+static const char* const STATUS_NAMES[] = {
+    "SUCCESS", "ALLOCATION_ERROR", "INVALID_INPUT", "FAILURE"
+};
+
+static const int FINDING_BYTES = 160;
+
+static unsigned long long next_random(unsigned long long& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static int random_below(unsigned long long& state, int bound) {
+    return static_cast<int>(next_random(state) % static_cast<unsigned long long>(bound));
+}
+
+class ReferenceModel;
+
+// Something that executes commands; created fresh for every sequence
+class Engine {
+public:
+    virtual ~Engine() {}
+    // Called with the whole sequence before its first command is executed
+    virtual void plan(const Command*, int) {}
+    virtual CommandResult execute(const Command& command) = 0;
+    // Checks what the command answers do not show (queries beyond the
+    // protocol) against the reference after both ran the same command.
+    // Returns a description of the first disagreement, or nullptr.
+    virtual const char* audit(const ReferenceModel&) { return nullptr; }
+};
+
+// The specification, written for obviousness rather than speed: IDs index
+// plain arrays, merged teams forward to the team that absorbed them,
+// unite_by_record scans every team, and every match credits each member of
+// both teams with its result (for get_team_record_since_joined).
+class ReferenceModel : public Engine {
+public:
+    enum Kind {
+        TEAM = 0,
+        JOCKEY = 1
+    };
+
+private:
+    // One record change, logged for the point-in-time queries
+    struct Change {
+        int m_kind;
+        int m_id;
+        int m_match_count;      // Successful matches when it happened
+        int m_delta;
+    };
+
+    int m_max_team;
+    int m_max_jockey;
+    std::unique_ptr<bool[]> m_team_added;
+    std::unique_ptr<int[]> m_merged_into;       // 0 while the team is alive
+    std::unique_ptr<int[]> m_team_record;
+    std::unique_ptr<int[]> m_jockey_team;       // 0 if the jockey does not exist
+    std::unique_ptr<int[]> m_jockey_record;
+    std::unique_ptr<int[]> m_since_joined;      // Team results since the jockey joined
+    std::unique_ptr<int[]> m_first_member;      // Per team, 0 if it has no jockeys
+    std::unique_ptr<int[]> m_last_member;
+    std::unique_ptr<int[]> m_next_member;       // Per jockey, 0 at the end of the list
+    int m_match_count;
+    std::unique_ptr<Change[]> m_changes;
+    int m_change_count;
+    int m_change_capacity;
+
+    void log_change(Kind kind, int id, int delta) {
+        if (m_change_count == m_change_capacity) {
+            m_change_capacity = m_change_capacity ? 2 * m_change_capacity : 256;
+            std::unique_ptr<Change[]> bigger(new Change[m_change_capacity]);
+            for (int i = 0; i < m_change_count; ++i) {
+                bigger[i] = m_changes[i];
+            }
+            m_changes.swap(bigger);
+        }
+        Change& change = m_changes[m_change_count++];
+        change.m_kind = kind;
+        change.m_id = id;
+        change.m_match_count = m_match_count;
+        change.m_delta = delta;
+    }
+
+    static CommandResult result(StatusType status, int answer = 0) {
+        CommandResult out;
+        out.m_status = static_cast<int32_t>(status);
+        out.m_answer = answer;
+        return out;
+    }
+
+    bool team_alive(int teamId) const {
+        return teamId > 0 && teamId <= m_max_team && m_team_added[teamId] && m_merged_into[teamId] == 0;
+    }
+
+    int current_team(int jockeyId) const {
+        int team = m_jockey_team[jockeyId];
+        while (m_merged_into[team] != 0) {
+            team = m_merged_into[team];
+        }
+        return team;
+    }
+
+    bool jockey_exists(int jockeyId) const {
+        return jockeyId > 0 && jockeyId <= m_max_jockey && m_jockey_team[jockeyId] != 0;
+    }
+
+    StatusType merge(int teamId1, int teamId2) {
+        if (teamId1 <= 0 || teamId2 <= 0 || teamId1 == teamId2) {
+            return StatusType::INVALID_INPUT;
+        }
+        if (!team_alive(teamId1) || !team_alive(teamId2)) {
+            return StatusType::FAILURE;
+        }
+        // Better record keeps its ID, teamId1 on a tie
+        int survivor = m_team_record[teamId2] > m_team_record[teamId1] ? teamId2 : teamId1;
+        int absorbed = survivor == teamId1 ? teamId2 : teamId1;
+        m_team_record[survivor] += m_team_record[absorbed];
+        log_change(TEAM, survivor, m_team_record[absorbed]);
+        m_merged_into[absorbed] = survivor;
+        if (m_first_member[absorbed] != 0) {
+            if (m_first_member[survivor] == 0) {
+                m_first_member[survivor] = m_first_member[absorbed];
+            } else {
+                m_next_member[m_last_member[survivor]] = m_first_member[absorbed];
+            }
+            m_last_member[survivor] = m_last_member[absorbed];
+            m_first_member[absorbed] = 0;
+        }
+        return StatusType::SUCCESS;
+    }
+
+    void credit_members(int team, int result) {
+        for (int jockey = m_first_member[team]; jockey != 0; jockey = m_next_member[jockey]) {
+            m_since_joined[jockey] += result;
+        }
+    }
+
+public:
+    ReferenceModel(int maxTeam, int maxJockey)
+        : m_max_team(maxTeam), m_max_jockey(maxJockey),
+          m_team_added(new bool[maxTeam + 1]()), m_merged_into(new int[maxTeam + 1]()),
+          m_team_record(new int[maxTeam + 1]()), m_jockey_team(new int[maxJockey + 1]()),
+          m_jockey_record(new int[maxJockey + 1]()), m_since_joined(new int[maxJockey + 1]()),
+          m_first_member(new int[maxTeam + 1]()), m_last_member(new int[maxTeam + 1]()),
+          m_next_member(new int[maxJockey + 1]()), m_match_count(0), m_changes(), m_change_count(0),
+          m_change_capacity(0) {}
+
+    int max_team() const { return m_max_team; }
+    int max_jockey() const { return m_max_jockey; }
+    int match_count() const { return m_match_count; }
+
+    bool exists(Kind kind, int id) const {
+        return kind == TEAM ? team_alive(id) : jockey_exists(id);
+    }
+
+    // Added once and merged into another team since
+    bool team_retired(int teamId) const {
+        return m_team_added[teamId] && m_merged_into[teamId] != 0;
+    }
+
+    int record(Kind kind, int id) const {
+        return kind == TEAM ? m_team_record[id] : m_jockey_record[id];
+    }
+
+    // Of an existing jockey
+    int jockey_team_record(int jockeyId) const {
+        return m_team_record[current_team(jockeyId)];
+    }
+
+    int since_joined(int jockeyId) const {
+        return m_since_joined[jockeyId];
+    }
+
+    // Record of a live team or an existing rider right after match
+    // matchCount (and the merges that followed it): the current record with
+    // every later change undone
+    int record_at(Kind kind, int id, int matchCount) const {
+        int current = record(kind, id);
+        for (int i = m_change_count - 1; i >= 0 && m_changes[i].m_match_count > matchCount; --i) {
+            if (m_changes[i].m_kind == kind && m_changes[i].m_id == id) {
+                current -= m_changes[i].m_delta;
+            }
+        }
+        return current;
+    }
+
+    CommandResult execute(const Command& command) override {
+        int a = command.m_args[0];
+        int b = command.m_args[1];
+        switch (static_cast<Opcode>(command.m_opcode)) {
+            case Opcode::ADD_TEAM:
+                if (a <= 0) {
+                    return result(StatusType::INVALID_INPUT);
+                }
+                if (m_team_added[a]) {
+                    return result(StatusType::FAILURE);
+                }
+                m_team_added[a] = true;
+                return result(StatusType::SUCCESS);
+            case Opcode::ADD_JOCKEY:
+                if (a <= 0 || b <= 0) {
+                    return result(StatusType::INVALID_INPUT);
+                }
+                if (jockey_exists(a) || !team_alive(b)) {
+                    return result(StatusType::FAILURE);
+                }
+                m_jockey_team[a] = b;
+                if (m_first_member[b] == 0) {
+                    m_first_member[b] = a;
+                } else {
+                    m_next_member[m_last_member[b]] = a;
+                }
+                m_last_member[b] = a;
+                return result(StatusType::SUCCESS);
+            case Opcode::UPDATE_MATCH:
+                if (a <= 0 || b <= 0 || a == b) {
+                    return result(StatusType::INVALID_INPUT);
+                }
+                if (!jockey_exists(a) || !jockey_exists(b) || current_team(a) == current_team(b)) {
+                    return result(StatusType::FAILURE);
+                }
+                m_match_count++;
+                m_jockey_record[a]++;
+                m_jockey_record[b]--;
+                m_team_record[current_team(a)]++;
+                m_team_record[current_team(b)]--;
+                log_change(JOCKEY, a, 1);
+                log_change(JOCKEY, b, -1);
+                log_change(TEAM, current_team(a), 1);
+                log_change(TEAM, current_team(b), -1);
+                credit_members(current_team(a), 1);
+                credit_members(current_team(b), -1);
+                return result(StatusType::SUCCESS);
+            case Opcode::MERGE_TEAMS:
+                return result(merge(a, b));
+            case Opcode::UNITE_BY_RECORD: {
+                if (a <= 0) {
+                    return result(StatusType::INVALID_INPUT);
+                }
+                int positive = 0;
+                int negative = 0;
+                int positiveCount = 0;
+                int negativeCount = 0;
+                for (int team = 1; team <= m_max_team; ++team) {
+                    if (!team_alive(team)) {
+                        continue;
+                    }
+                    if (m_team_record[team] == a) {
+                        positive = team;
+                        positiveCount++;
+                    } else if (m_team_record[team] == -a) {
+                        negative = team;
+                        negativeCount++;
+                    }
+                }
+                if (positiveCount != 1 || negativeCount != 1) {
+                    return result(StatusType::FAILURE);
+                }
+                return result(merge(positive, negative));
+            }
+            case Opcode::GET_JOCKEY_RECORD:
+                if (a <= 0) {
+                    return result(StatusType::INVALID_INPUT);
+                }
+                if (!jockey_exists(a)) {
+                    return result(StatusType::FAILURE);
+                }
+                return result(StatusType::SUCCESS, m_jockey_record[a]);
+            case Opcode::GET_TEAM_RECORD:
+                if (a <= 0) {
+                    return result(StatusType::INVALID_INPUT);
+                }
+                if (!team_alive(a)) {
+                    return result(StatusType::FAILURE);
+                }
+                return result(StatusType::SUCCESS, m_team_record[a]);
+        }
+        return result(StatusType::INVALID_INPUT);
+    }
+};
+
+// Audits the team-relative rider queries of a few random jockeys, which
+// depend on the union-find offsets that compaction and relinking rewrite
+static const char* audit_rider_queries(Plains& plains, const ReferenceModel& reference,
+                                       unsigned long long& random, char* finding) {
+    for (int i = 0; i < 2; ++i) {
+        int jockey = random_below(random, reference.max_jockey() + 2);
+        bool exists = reference.exists(ReferenceModel::JOCKEY, jockey);
+        StatusType status = jockey <= 0 ? StatusType::INVALID_INPUT
+                                        : exists ? StatusType::SUCCESS : StatusType::FAILURE;
+        const char* names[2] = {"get_team_record_since_joined", "get_jockey_team_record"};
+        for (int query = 0; query < 2; ++query) {
+            int expected = !exists ? 0 : query == 0 ? reference.since_joined(jockey)
+                                                   : reference.jockey_team_record(jockey);
+            output_t<int> actual = query == 0 ? plains.get_team_record_since_joined(jockey)
+                                              : plains.get_jockey_team_record(jockey);
+            int answer = actual.status() == StatusType::SUCCESS ? actual.ans() : 0;
+            if (actual.status() != status || answer != expected) {
+                snprintf(finding, FINDING_BYTES, "%s(%d): expected %s %d, got %s %d", names[query], jockey,
+                         STATUS_NAMES[static_cast<int>(status)], expected,
+                         STATUS_NAMES[static_cast<int>(actual.status())], answer);
+                return finding;
+            }
+        }
+    }
+    return nullptr;
+}
+
+class PlainsEngine : public Engine {
+private:
+    Plains m_plains;
+    unsigned long long m_random;
+    char m_finding[FINDING_BYTES];
+
+public:
+    PlainsEngine(bool lazyRecords, int compactionThreshold) : m_random(0x9E3779B97F4A7C15ull) {
+        m_plains.set_lazy_record_index(lazyRecords);
+        m_plains.set_compaction_threshold(compactionThreshold);
+    }
+
+    CommandResult execute(const Command& command) override {
+        return execute_command(m_plains, command);
+    }
+
+    const char* audit(const ReferenceModel& reference) override {
+        return audit_rider_queries(m_plains, reference, m_random, m_finding);
+    }
+};
+
+// Bounded-latency mode with a small relink budget. Automatic compaction is
+// off in that mode, so it compacts explicitly to cover the relink list rebuild.
+class BoundedPlainsEngine : public Engine {
+private:
+    Plains m_plains;
+    int m_step;
+    unsigned long long m_random;
+    char m_finding[FINDING_BYTES];
+
+public:
+    BoundedPlainsEngine() : m_step(0), m_random(0xD1B54A32D192ED03ull) {
+        m_plains.set_bounded_latency(2);
+    }
+
+    CommandResult execute(const Command& command) override {
+        if (++m_step % 7 == 0) {
+            m_plains.compact_nodes();
+        }
+        return execute_command(m_plains, command);
+    }
+
+    const char* audit(const ReferenceModel& reference) override {
+        return audit_rider_queries(m_plains, reference, m_random, m_finding);
+    }
+};
+
+// Answers get_team_record from the team columns instead of the ID map, so
+// the replica's rows (and their swap-removal on merges) are checked too.
+// It also feeds the match sketches, which must not change any result.
+class ColumnarPlainsEngine : public Engine {
+private:
+    Plains m_plains;
+
+public:
+    ColumnarPlainsEngine() {
+        m_plains.set_match_sketches(true);
+        m_plains.set_sketch_window(5);
+    }
+
+    CommandResult execute(const Command& command) override {
+        if (static_cast<Opcode>(command.m_opcode) != Opcode::GET_TEAM_RECORD || command.m_args[0] <= 0) {
+            return execute_command(m_plains, command);
+        }
+        const TeamColumns& columns = m_plains.team_columns();
+        CommandResult result;
+        result.m_status = static_cast<int32_t>(StatusType::FAILURE);
+        result.m_answer = 0;
+        for (int row = 0; row < columns.get_size(); ++row) {
+            if (columns.ids()[row] == command.m_args[0]) {
+                result.m_status = static_cast<int32_t>(StatusType::SUCCESS);
+                result.m_answer = columns.records()[row];
+            }
+        }
+        return result;
+    }
+};
+
+// Answers get_team_record from the record history, as of the latest match,
+// so its blocks are decoded on every query. The retention is short and
+// changes every RETENTION_PERIOD commands, so blocks keep expiring and coming
+// back from the pool and the window shrinks under live streams. After every
+// command the audit asks for team and rider records at random match counts
+// in and around the window and compares them with the reference's log.
+class HistoryPlainsEngine : public Engine {
+private:
+    static const int RETENTION_PERIOD = 150;
+    static const int RETENTION_COUNT = 4;
+
+    Plains m_plains;
+    int m_step;
+    int m_retention;
+    int m_match_count;
+    int m_window_start;     // Oldest match count the history can answer for
+    unsigned long long m_random;
+    char m_finding[FINDING_BYTES];
+
+    static int retention_for(int period) {
+        static const int RETENTIONS[RETENTION_COUNT] = {3, 12, 1, 6};
+        return RETENTIONS[period % RETENTION_COUNT];
+    }
+
+    // Expected status and answer of a query, known to the spec: the subject
+    // must exist and matchCount must lie in the window
+    CommandResult expected_at(const ReferenceModel& reference, ReferenceModel::Kind kind, int id,
+                              int matchCount) const {
+        CommandResult result;
+        result.m_answer = 0;
+        if (id <= 0 || matchCount < 0) {
+            result.m_status = static_cast<int32_t>(StatusType::INVALID_INPUT);
+        } else if (!reference.exists(kind, id) || matchCount < m_window_start || matchCount > m_match_count) {
+            result.m_status = static_cast<int32_t>(StatusType::FAILURE);
+        } else {
+            result.m_status = static_cast<int32_t>(StatusType::SUCCESS);
+            result.m_answer = reference.record_at(kind, id, matchCount);
+        }
+        return result;
+    }
+
+    // The record now minus the record lastMatches matches ago
+    CommandResult expected_change(const ReferenceModel& reference, int jockeyId, int lastMatches) const {
+        if (jockeyId <= 0 || lastMatches < 0) {
+            return expected_at(reference, ReferenceModel::JOCKEY, jockeyId, -1);
+        }
+        // Further back than match 0 is outside every window
+        CommandResult result = expected_at(reference, ReferenceModel::JOCKEY, jockeyId, m_match_count - lastMatches);
+        if (lastMatches > m_match_count) {
+            result.m_status = static_cast<int32_t>(StatusType::FAILURE);
+        }
+        if (result.m_status == static_cast<int32_t>(StatusType::SUCCESS)) {
+            result.m_answer = reference.record_at(ReferenceModel::JOCKEY, jockeyId, m_match_count) - result.m_answer;
+        }
+        return result;
+    }
+
+    const char* compare(const char* query, int id, int argument, const CommandResult& expected,
+                        output_t<int> actual) {
+        int answer = actual.status() == StatusType::SUCCESS ? actual.ans() : 0;
+        if (expected.m_status == static_cast<int32_t>(actual.status()) && expected.m_answer == answer) {
+            return nullptr;
+        }
+        snprintf(m_finding, FINDING_BYTES, "%s(%d, %d) at match %d, window from %d: expected %s %d, got %s %d",
+                 query, id, argument, m_match_count, m_window_start, STATUS_NAMES[expected.m_status],
+                 expected.m_answer, STATUS_NAMES[static_cast<int>(actual.status())], answer);
+        return m_finding;
+    }
+
+public:
+    HistoryPlainsEngine() : m_step(0), m_retention(retention_for(0)), m_match_count(0), m_window_start(0),
+                            m_random(0x2545F4914F6CDD1Dull) {
+        m_plains.set_record_history(m_retention);
+        m_finding[0] = '\0';
+    }
+
+    CommandResult execute(const Command& command) override {
+        if (++m_step % RETENTION_PERIOD == 0) {
+            m_retention = retention_for(m_step / RETENTION_PERIOD);
+            m_plains.set_record_history(m_retention);
+        }
+        CommandResult result = execute_command(m_plains, command);
+        if (static_cast<Opcode>(command.m_opcode) == Opcode::GET_TEAM_RECORD &&
+            result.m_status == static_cast<int32_t>(StatusType::SUCCESS)) {
+            result.m_answer = m_plains.get_team_record_at(command.m_args[0], m_plains.get_match_count()).ans();
+        }
+        return result;
+    }
+
+    const char* audit(const ReferenceModel& reference) override {
+        // The window follows the matches; a shrunk retention takes effect
+        // with the next match, a grown one never brings old matches back
+        if (reference.match_count() != m_match_count) {
+            m_match_count = reference.match_count();
+            int start = m_match_count - m_retention;
+            m_window_start = start > m_window_start ? start : m_window_start;
+        }
+        int span = m_match_count - m_window_start + 5;
+        for (int i = 0; i < 2; ++i) {
+            int team = random_below(m_random, reference.max_team() + 2);
+            int jockey = random_below(m_random, reference.max_jockey() + 2);
+            int matchCount = m_window_start - 2 + random_below(m_random, span);
+            const char* finding = compare("get_team_record_at", team, matchCount,
+                                          expected_at(reference, ReferenceModel::TEAM, team, matchCount),
+                                          m_plains.get_team_record_at(team, matchCount));
+            if (!finding) {
+                finding = compare("get_jockey_record_at", jockey, matchCount,
+                                  expected_at(reference, ReferenceModel::JOCKEY, jockey, matchCount),
+                                  m_plains.get_jockey_record_at(jockey, matchCount));
+            }
+            if (!finding) {
+                int lastMatches = m_match_count - matchCount;
+                finding = compare("get_jockey_record_change", jockey, lastMatches,
+                                  expected_change(reference, jockey, lastMatches),
+                                  m_plains.get_jockey_record_change(jockey, lastMatches));
+            }
+            if (finding) {
+                return finding;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// Consumes the change feed like a downstream replica of the team records:
+// every event is applied to one replica as it is polled, and each batch of
+// BATCH_COMMANDS commands' events is coalesced and applied to a second one.
+// The audit checks the teams of new events in the first replica against the
+// reference after every command, and at every batch end all teams of both.
+class FeedPlainsEngine : public Engine {
+private:
+    static const int BATCH_COMMANDS = 16;
+    static const int BATCH_EVENTS = 4 * BATCH_COMMANDS;  // At most 2 per command
+
+    // Team records as a subscriber sees them; unknown teams have record 0
+    struct Replica {
+        std::unique_ptr<int[]> m_record;
+        std::unique_ptr<bool[]> m_retired;
+
+        void reset(int maxTeam) {
+            m_record.reset(new int[maxTeam + 1]());
+            m_retired.reset(new bool[maxTeam + 1]());
+        }
+
+        void apply(const ChangeEvent& event) {
+            switch (event.m_type) {
+                case ChangeEvent::RECORD_CHANGED:
+                    m_record[event.m_team] += event.m_value;
+                    break;
+                case ChangeEvent::TEAMS_MERGED:
+                    m_record[event.m_team] = event.m_value;
+                    break;
+                case ChangeEvent::TEAM_RETIRED:
+                    m_retired[event.m_team] = true;
+                    break;
+            }
+        }
+    };
+
+    Plains m_plains;
+    std::unique_ptr<ChangeFeed::Subscriber> m_subscriber;
+    int m_max_team;
+    Replica m_events;
+    Replica m_batches;
+    ChangeEvent m_batch[BATCH_EVENTS];
+    int m_batch_size;
+    int m_step;
+    char m_finding[FINDING_BYTES];
+
+    const char* check_team(int team, const Replica& replica, const char* label, bool retired, int record) {
+        if (replica.m_retired[team] == retired && (retired || replica.m_record[team] == record)) {
+            return nullptr;
+        }
+        snprintf(m_finding, FINDING_BYTES, "%s has team %d %s with record %d, expected %s with record %d", label,
+                 team, replica.m_retired[team] ? "retired" : "live", replica.m_record[team],
+                 retired ? "retired" : "live", record);
+        return m_finding;
+    }
+
+public:
+    FeedPlainsEngine() : m_max_team(0), m_batch_size(0), m_step(0) {
+        m_subscriber.reset(new ChangeFeed::Subscriber(*m_plains.change_feed()));
+        m_finding[0] = '\0';
+    }
+
+    CommandResult execute(const Command& command) override {
+        return execute_command(m_plains, command);
+    }
+
+    const char* audit(const ReferenceModel& reference) override {
+        if (m_max_team != reference.max_team()) {
+            m_max_team = reference.max_team();
+            m_events.reset(m_max_team);
+            m_batches.reset(m_max_team);
+        }
+        int first = m_batch_size;
+        int polled;
+        while ((polled = m_subscriber->poll(m_batch + m_batch_size, BATCH_EVENTS - m_batch_size)) > 0) {
+            for (int i = 0; i < polled; ++i) {
+                m_events.apply(m_batch[m_batch_size + i]);
+            }
+            m_batch_size += polled;
+        }
+        if (m_subscriber->get_missed() != 0) {
+            snprintf(m_finding, FINDING_BYTES, "subscriber missed %llu events",
+                     static_cast<unsigned long long>(m_subscriber->get_missed()));
+            return m_finding;
+        }
+        for (int i = first; i < m_batch_size; ++i) {
+            int teams[2] = {m_batch[i].m_team, m_batch[i].m_other};
+            for (int side = 0; side < 2 && teams[side] != 0; ++side) {
+                const char* finding = check_team(teams[side], m_events, "event replica",
+                                                 reference.team_retired(teams[side]),
+                                                 reference.record(ReferenceModel::TEAM, teams[side]));
+                if (finding) {
+                    return finding;
+                }
+            }
+        }
+        if (++m_step % BATCH_COMMANDS != 0) {
+            return nullptr;
+        }
+        int kept = coalesce_events(m_batch, m_batch_size);
+        for (int i = 0; i < kept; ++i) {
+            m_batches.apply(m_batch[i]);
+        }
+        m_batch_size = 0;
+        for (int team = 1; team <= m_max_team; ++team) {
+            bool retired = reference.team_retired(team);
+            int record = reference.record(ReferenceModel::TEAM, team);
+            const char* finding = check_team(team, m_events, "event replica", retired, record);
+            if (!finding) {
+                finding = check_team(team, m_batches, "coalesced replica", retired, record);
+            }
+            if (finding) {
+                return finding;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// Builds the league with bulk_load: every run of add_team commands followed
+// by a run of add_jockey commands becomes one batch, loaded when its first
+// command comes up, and each command answers with the status of its row.
+// bulk_load must behave exactly like the single adds in order, including
+// duplicates inside the batch, retired team IDs and riders without a team.
+class BulkLoadPlainsEngine : public Engine {
+private:
+    Plains m_plains;
+    const Command* m_commands;
+    int m_count;
+    int m_step;
+    int m_batch_end;                            // Commands before it are loaded
+    std::unique_ptr<StatusType[]> m_statuses;   // Row statuses, by command index
+
+    static bool is_opcode(const Command& command, Opcode opcode) {
+        return static_cast<Opcode>(command.m_opcode) == opcode;
+    }
+
+    void load_batch(int begin) {
+        int teamsEnd = begin;
+        while (teamsEnd < m_count && is_opcode(m_commands[teamsEnd], Opcode::ADD_TEAM)) {
+            teamsEnd++;
+        }
+        int end = teamsEnd;
+        while (end < m_count && is_opcode(m_commands[end], Opcode::ADD_JOCKEY)) {
+            end++;
+        }
+        int numTeams = teamsEnd - begin;
+        int numJockeys = end - teamsEnd;
+        std::unique_ptr<int[]> teamIds(new int[numTeams + 1]);
+        std::unique_ptr<int[]> jockeyIds(new int[numJockeys + 1]);
+        std::unique_ptr<int[]> jockeyTeamIds(new int[numJockeys + 1]);
+        for (int i = 0; i < numTeams; ++i) {
+            teamIds[i] = m_commands[begin + i].m_args[0];
+        }
+        for (int i = 0; i < numJockeys; ++i) {
+            jockeyIds[i] = m_commands[teamsEnd + i].m_args[0];
+            jockeyTeamIds[i] = m_commands[teamsEnd + i].m_args[1];
+        }
+        m_plains.bulk_load(teamIds.get(), numTeams, jockeyIds.get(), jockeyTeamIds.get(), numJockeys,
+                           m_statuses.get() + begin, m_statuses.get() + teamsEnd);
+        m_batch_end = end;
+    }
+
+public:
+    BulkLoadPlainsEngine() : m_commands(nullptr), m_count(0), m_step(0), m_batch_end(0) {}
+
+    void plan(const Command* commands, int count) override {
+        m_commands = commands;
+        m_count = count;
+        m_statuses.reset(new StatusType[count]);
+    }
+
+    CommandResult execute(const Command& command) override {
+        int step = m_step++;
+        if (!is_opcode(command, Opcode::ADD_TEAM) && !is_opcode(command, Opcode::ADD_JOCKEY)) {
+            return execute_command(m_plains, command);
+        }
+        if (step >= m_batch_end) {
+            load_batch(step);
+        }
+        CommandResult result;
+        result.m_status = static_cast<int32_t>(m_statuses[step]);
+        result.m_answer = 0;
+        return result;
+    }
+};
+
+// The packed engine, which has no Command entry point of its own
+class CompactPlainsEngine : public Engine {
+private:
+    CompactPlains m_plains;
+
+public:
+    CommandResult execute(const Command& command) override {
+        const int32_t* args = command.m_args;
+        StatusType status = StatusType::INVALID_INPUT;
+        int answer = 0;
+        switch (static_cast<Opcode>(command.m_opcode)) {
+            case Opcode::ADD_TEAM:
+                status = m_plains.add_team(args[0]);
+                break;
+            case Opcode::ADD_JOCKEY:
+                status = m_plains.add_jockey(args[0], args[1]);
+                break;
+            case Opcode::UPDATE_MATCH:
+                status = m_plains.update_match(args[0], args[1]);
+                break;
+            case Opcode::MERGE_TEAMS:
+                status = m_plains.merge_teams(args[0], args[1]);
+                break;
+            case Opcode::UNITE_BY_RECORD:
+                status = m_plains.unite_by_record(args[0]);
+                break;
+            case Opcode::GET_JOCKEY_RECORD: {
+                output_t<int> output = m_plains.get_jockey_record(args[0]);
+                status = output.status();
+                answer = output.ans();
+                break;
+            }
+            case Opcode::GET_TEAM_RECORD: {
+                output_t<int> output = m_plains.get_team_record(args[0]);
+                status = output.status();
+                answer = output.ans();
+                break;
+            }
+        }
+        CommandResult result;
+        result.m_status = static_cast<int32_t>(status);
+        result.m_answer = status == StatusType::SUCCESS ? answer : 0;
+        return result;
+    }
+};
+
+// One league of a LeagueRegistry that also hosts a few other, busy leagues
+class LeagueEngine : public Engine {
+private:
+    static const int LEAGUE = 7;
+    LeagueRegistry m_registry;
+    int m_step;
+
+public:
+    LeagueEngine() : m_step(0) {
+        for (int league = 1; league <= 3; ++league) {
+            m_registry.create_league(LEAGUE + league);
+        }
+        m_registry.create_league(LEAGUE);
+    }
+
+    CommandResult execute(const Command& command) override {
+        // Mirror the command into a neighbour league, so keys of different
+        // leagues share the maps
+        int neighbour = LEAGUE + 1 + (m_step++ % 3);
+        run(neighbour, command);
+        return run(LEAGUE, command);
+    }
+
+    CommandResult run(int league, const Command& command) {
+        const int32_t* args = command.m_args;
+        StatusType status = StatusType::INVALID_INPUT;
+        int answer = 0;
+        switch (static_cast<Opcode>(command.m_opcode)) {
+            case Opcode::ADD_TEAM:
+                status = m_registry.add_team(league, args[0]);
+                break;
+            case Opcode::ADD_JOCKEY:
+                status = m_registry.add_jockey(league, args[0], args[1]);
+                break;
+            case Opcode::UPDATE_MATCH:
+                status = m_registry.update_match(league, args[0], args[1]);
+                break;
+            case Opcode::MERGE_TEAMS:
+                status = m_registry.merge_teams(league, args[0], args[1]);
+                break;
+            case Opcode::UNITE_BY_RECORD:
+                status = m_registry.unite_by_record(league, args[0]);
+                break;
+            case Opcode::GET_JOCKEY_RECORD: {
+                output_t<int> output = m_registry.get_jockey_record(league, args[0]);
+                status = output.status();
+                answer = output.ans();
+                break;
+            }
+            case Opcode::GET_TEAM_RECORD: {
+                output_t<int> output = m_registry.get_team_record(league, args[0]);
+                status = output.status();
+                answer = output.ans();
+                break;
+            }
+        }
+        CommandResult result;
+        result.m_status = static_cast<int32_t>(status);
+        result.m_answer = status == StatusType::SUCCESS ? answer : 0;
+        return result;
+    }
+};
+
+// The engine variants under test
+static const int ENGINE_COUNT = 10;
+static const char* const ENGINE_NAMES[ENGINE_COUNT] = {
+    "plains", "plains-lazy", "plains-compacting", "plains-bounded", "plains-columnar",
+    "plains-history", "plains-feed", "plains-bulk", "compact-plains", "league-registry"
+};
+
+static Engine* make_engine(int engine) {
+    switch (engine) {
+        case 0: return new PlainsEngine(false, 0);
+        case 1: return new PlainsEngine(true, 0);
+        case 2: return new PlainsEngine(true, 3);
+        case 3: return new BoundedPlainsEngine();
+        case 4: return new ColumnarPlainsEngine();
+        case 5: return new HistoryPlainsEngine();
+        case 6: return new FeedPlainsEngine();
+        case 7: return new BulkLoadPlainsEngine();
+        case 8: return new CompactPlainsEngine();
+        default: return new LeagueEngine();
+    }
+}
+
+// Shapes of one random sequence: small ID universes make collisions,
+// duplicates and merges of merged teams common
+struct CaseShape {
+    int m_max_team;
+    int m_max_jockey;
+    int m_max_record;
+};
+
+// An ID in [-1, max]; 0 and -1 exercise INVALID_INPUT
+static int random_id(unsigned long long& state, int max) {
+    return random_below(state, 64) == 0 ? -random_below(state, 2) : 1 + random_below(state, max);
+}
+
+static CaseShape random_shape(unsigned long long& state) {
+    CaseShape shape;
+    shape.m_max_team = 2 + random_below(state, 40);
+    shape.m_max_jockey = 2 + random_below(state, 200);
+    shape.m_max_record = 1 + random_below(state, 8);
+    return shape;
+}
+
+static void random_commands(unsigned long long& state, const CaseShape& shape, Command* commands, int count) {
+    for (int i = 0; i < count; ++i) {
+        Command& command = commands[i];
+        int roll = random_below(state, 100);
+        command.m_args[1] = 0;
+        if (roll < 8) {
+            command.m_opcode = static_cast<int32_t>(Opcode::ADD_TEAM);
+            command.m_args[0] = random_id(state, shape.m_max_team);
+        } else if (roll < 25) {
+            command.m_opcode = static_cast<int32_t>(Opcode::ADD_JOCKEY);
+            command.m_args[0] = random_id(state, shape.m_max_jockey);
+            command.m_args[1] = random_id(state, shape.m_max_team);
+        } else if (roll < 65) {
+            command.m_opcode = static_cast<int32_t>(Opcode::UPDATE_MATCH);
+            command.m_args[0] = random_id(state, shape.m_max_jockey);
+            command.m_args[1] = random_id(state, shape.m_max_jockey);
+        } else if (roll < 72) {
+            command.m_opcode = static_cast<int32_t>(Opcode::MERGE_TEAMS);
+            command.m_args[0] = random_id(state, shape.m_max_team);
+            command.m_args[1] = random_id(state, shape.m_max_team);
+        } else if (roll < 84) {
+            command.m_opcode = static_cast<int32_t>(Opcode::UNITE_BY_RECORD);
+            command.m_args[0] = random_id(state, shape.m_max_record);
+        } else if (roll < 92) {
+            command.m_opcode = static_cast<int32_t>(Opcode::GET_JOCKEY_RECORD);
+            command.m_args[0] = random_id(state, shape.m_max_jockey);
+        } else {
+            command.m_opcode = static_cast<int32_t>(Opcode::GET_TEAM_RECORD);
+            command.m_args[0] = random_id(state, shape.m_max_team);
+        }
+    }
+}
+
+static bool same_result(const CommandResult& a, const CommandResult& b) {
+    return a.m_status == b.m_status && a.m_answer == b.m_answer;
+}
+
+// Index of the first command where the engine disagrees with the reference,
+// or -1 if it never does. When the answers agree but the engine's audit
+// does not, finding receives the audit's description (else it is empty).
+static int first_divergence(int engine, const CaseShape& shape, const Command* commands, int count,
+                            CommandResult* expected, CommandResult* actual, char* finding) {
+    ReferenceModel reference(shape.m_max_team, shape.m_max_jockey);
+    std::unique_ptr<Engine> subject(make_engine(engine));
+    subject->plan(commands, count);
+    finding[0] = '\0';
+    for (int i = 0; i < count; ++i) {
+        *expected = reference.execute(commands[i]);
+        *actual = subject->execute(commands[i]);
+        if (!same_result(*expected, *actual)) {
+            return i;
+        }
+        const char* audit = subject->audit(reference);
+        if (audit) {
+            snprintf(finding, FINDING_BYTES, "%s", audit);
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Delta debugging: drop ever smaller chunks of the sequence while the engine
+// still diverges. Returns the new length; commands is shrunk in place.
+static int shrink(int engine, const CaseShape& shape, Command* commands, int count) {
+    CommandResult expected;
+    CommandResult actual;
+    char finding[FINDING_BYTES];
+    count = first_divergence(engine, shape, commands, count, &expected, &actual, finding) + 1;
+    std::unique_ptr<Command[]> trial(new Command[count]);
+    for (int chunk = count / 2; chunk >= 1; chunk /= 2) {
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (int start = 0; start + chunk <= count; ) {
+                int length = 0;
+                for (int i = 0; i < count; ++i) {
+                    if (i < start || i >= start + chunk) {
+                        trial[length++] = commands[i];
+                    }
+                }
+                int divergence = first_divergence(engine, shape, trial.get(), length, &expected, &actual, finding);
+                if (divergence >= 0) {
+                    count = divergence + 1;
+                    for (int i = 0; i < count; ++i) {
+                        commands[i] = trial[i];
+                    }
+                    progress = true;
+                } else {
+                    start += chunk;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+static void print_command(FILE* out, const Command& command) {
+    int opcode = command.m_opcode;
+    fprintf(out, "%s", OPCODE_NAMES[opcode]);
+    for (int arg = 0; arg < OPCODE_ARITY[opcode]; ++arg) {
+        fprintf(out, " %d", command.m_args[arg]);
+    }
+    fprintf(out, "\n");
+}
+
+static void print_result(FILE* out, const char* label, const CommandResult& result) {
+    fprintf(out, "  %-9s %s", label, STATUS_NAMES[result.m_status]);
+    if (result.m_status == static_cast<int32_t>(StatusType::SUCCESS)) {
+        fprintf(out, ", %d", result.m_answer);
+    }
+    fprintf(out, "\n");
+}
+
+// The answers of a divergent command, or the audit finding after it
+static void print_divergence(FILE* out, const CommandResult& expected, const CommandResult& actual,
+                             const char* finding) {
+    if (finding[0]) {
+        fprintf(out, "  audit     %s\n", finding);
+        return;
+    }
+    print_result(out, "expected", expected);
+    print_result(out, "actual", actual);
+}
+
+static void report(int engine, const CaseShape& shape, Command* commands, int count, unsigned long long seed) {
+    count = shrink(engine, shape, commands, count);
+    CommandResult expected;
+    CommandResult actual;
+    char finding[FINDING_BYTES];
+    first_divergence(engine, shape, commands, count, &expected, &actual, finding);
+    printf("MISMATCH in %s (case seed %llu), minimal repro with %d commands:\n",
+           ENGINE_NAMES[engine], seed, count);
+    for (int i = 0; i < count; ++i) {
+        print_command(stdout, commands[i]);
+    }
+    printf("last command:\n");
+    print_divergence(stdout, expected, actual, finding);
+}
+
+// One bulk_load batch big enough for the parallel hash table fill
+// (HashMap::PARALLEL_THRESHOLD new keys), loaded by worker threads into a
+// league that already has riders and retired teams, and checked row by row
+// and then command by command against the same rows added one at a time.
+static const int BULK_NEW_KEYS = 1 << 16;
+
+static int check_parallel_bulk_load(unsigned long long seed) {
+    unsigned long long state = seed | 1;
+    Plains bulk;
+    Plains single;
+    bulk.set_worker_threads(4);
+
+    // Existing state: 1000 teams with riders and matches, 200 of them merged away
+    const int oldTeams = 1000;
+    const int oldJockeys = 3000;
+    for (int team = 1; team <= oldTeams; ++team) {
+        bulk.add_team(team);
+        single.add_team(team);
+    }
+    for (int jockey = 1; jockey <= oldJockeys; ++jockey) {
+        int team = 1 + random_below(state, oldTeams);
+        bulk.add_jockey(jockey, team);
+        single.add_jockey(jockey, team);
+    }
+    for (int i = 0; i < 5000; ++i) {
+        int winner = 1 + random_below(state, oldJockeys);
+        int loser = 1 + random_below(state, oldJockeys);
+        bulk.update_match(winner, loser);
+        single.update_match(winner, loser);
+    }
+    for (int team = 1; team < 400; team += 2) {
+        bulk.merge_teams(team, team + 1);
+        single.merge_teams(team, team + 1);
+    }
+
+    // Mostly fresh IDs; the rest repeat an earlier ID (existing, retired or
+    // in this batch) or are invalid, and riders may name missing teams
+    const int numTeams = BULK_NEW_KEYS + BULK_NEW_KEYS / 4;
+    const int numJockeys = 3 * BULK_NEW_KEYS;
+    std::unique_ptr<int[]> teamIds(new int[numTeams]);
+    std::unique_ptr<int[]> jockeyIds(new int[numJockeys]);
+    std::unique_ptr<int[]> jockeyTeamIds(new int[numJockeys]);
+    int maxTeam = oldTeams;
+    for (int row = 0; row < numTeams; ++row) {
+        int roll = random_below(state, 16);
+        teamIds[row] = roll == 0 ? 1 + random_below(state, maxTeam) : roll == 1 ? -random_below(state, 2) : ++maxTeam;
+    }
+    int maxJockey = oldJockeys;
+    for (int row = 0; row < numJockeys; ++row) {
+        int roll = random_below(state, 16);
+        jockeyIds[row] = roll == 0 ? 1 + random_below(state, maxJockey) : roll == 1 ? -random_below(state, 2) : ++maxJockey;
+        jockeyTeamIds[row] = random_id(state, maxTeam + maxTeam / 8);
+    }
+
+    std::unique_ptr<StatusType[]> teamResults(new StatusType[numTeams]);
+    std::unique_ptr<StatusType[]> jockeyResults(new StatusType[numJockeys]);
+    StatusType status = bulk.bulk_load(teamIds.get(), numTeams, jockeyIds.get(), jockeyTeamIds.get(), numJockeys,
+                                       teamResults.get(), jockeyResults.get());
+    if (status != StatusType::SUCCESS) {
+        printf("MISMATCH in parallel bulk_load: returned %s\n", STATUS_NAMES[static_cast<int>(status)]);
+        return 1;
+    }
+    for (int row = 0; row < numTeams; ++row) {
+        StatusType expected = single.add_team(teamIds[row]);
+        if (teamResults[row] != expected) {
+            printf("MISMATCH in parallel bulk_load: add_team %d (row %d) expected %s, got %s\n", teamIds[row], row,
+                   STATUS_NAMES[static_cast<int>(expected)], STATUS_NAMES[static_cast<int>(teamResults[row])]);
+            return 1;
+        }
+    }
+    for (int row = 0; row < numJockeys; ++row) {
+        StatusType expected = single.add_jockey(jockeyIds[row], jockeyTeamIds[row]);
+        if (jockeyResults[row] != expected) {
+            printf("MISMATCH in parallel bulk_load: add_jockey %d %d (row %d) expected %s, got %s\n", jockeyIds[row],
+                   jockeyTeamIds[row], row, STATUS_NAMES[static_cast<int>(expected)],
+                   STATUS_NAMES[static_cast<int>(jockeyResults[row])]);
+            return 1;
+        }
+    }
+
+    // Final state: every ID, the columns, then random commands on both
+    Command command;
+    command.m_args[1] = 0;
+    for (int id = 1; id <= maxTeam + maxJockey; ++id) {
+        bool isTeam = id <= maxTeam;
+        command.m_opcode = static_cast<int32_t>(isTeam ? Opcode::GET_TEAM_RECORD : Opcode::GET_JOCKEY_RECORD);
+        command.m_args[0] = isTeam ? id : id - maxTeam;
+        if (!same_result(execute_command(single, command), execute_command(bulk, command))) {
+            printf("MISMATCH in parallel bulk_load: state of %s %d\n", isTeam ? "team" : "jockey", command.m_args[0]);
+            return 1;
+        }
+    }
+    if (bulk.team_columns().get_size() != single.team_columns().get_size()) {
+        printf("MISMATCH in parallel bulk_load: %d team rows, expected %d\n", bulk.team_columns().get_size(),
+               single.team_columns().get_size());
+        return 1;
+    }
+    CaseShape shape = {maxTeam, maxJockey, 4};
+    const int followUp = 50000;
+    std::unique_ptr<Command[]> commands(new Command[followUp]);
+    random_commands(state, shape, commands.get(), followUp);
+    for (int i = 0; i < followUp; ++i) {
+        if (!same_result(execute_command(single, commands[i]), execute_command(bulk, commands[i]))) {
+            printf("MISMATCH in parallel bulk_load: after the batch, at ");
+            print_command(stdout, commands[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int fuzz(double seconds, long long maxCases, int ops, unsigned long long seed) {
+    if (check_parallel_bulk_load(seed) != 0) {
+        return 1;
+    }
+    std::unique_ptr<Command[]> commands(new Command[ops]);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long long cases = 0;
+    long long executed = 0;
+    double elapsed = 0;
+    while ((maxCases == 0 || cases < maxCases) && (maxCases != 0 || elapsed < seconds)) {
+        unsigned long long caseSeed = seed + static_cast<unsigned long long>(cases) * 0x9E3779B97F4A7C15ull;
+        unsigned long long state = caseSeed | 1;
+        CaseShape shape = random_shape(state);
+        random_commands(state, shape, commands.get(), ops);
+
+        ReferenceModel reference(shape.m_max_team, shape.m_max_jockey);
+        std::unique_ptr<Engine> engines[ENGINE_COUNT];
+        for (int engine = 0; engine < ENGINE_COUNT; ++engine) {
+            engines[engine].reset(make_engine(engine));
+            engines[engine]->plan(commands.get(), ops);
+        }
+        for (int i = 0; i < ops; ++i) {
+            CommandResult expected = reference.execute(commands[i]);
+            for (int engine = 0; engine < ENGINE_COUNT; ++engine) {
+                if (!same_result(expected, engines[engine]->execute(commands[i])) ||
+                    engines[engine]->audit(reference)) {
+                    report(engine, shape, commands.get(), ops, caseSeed);
+                    return 1;
+                }
+            }
+        }
+        cases++;
+        executed += ops;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    printf("%lld cases, %lld commands x %d engines in %.2fs (%.0f commands/s per engine), no mismatch\n",
+           cases, executed, ENGINE_COUNT, elapsed, elapsed > 0 ? executed / elapsed : 0.0);
+    return 0;
+}
+
+// Runs a text command file through the reference and every engine
+static int replay(const char* path) {
+    FILE* in = fopen(path, "r");
+    if (!in) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return 2;
+    }
+    // IDs in a replay file are unbounded, so size the reference to the file
+    int capacity = 1024;
+    int count = 0;
+    std::unique_ptr<Command[]> commands(new Command[capacity]);
+    CaseShape shape = {1, 1, 1};
+    char word[32];
+    while (fscanf(in, "%31s", word) == 1) {
+        int opcode = 1;
+        while (opcode <= 7 && strcmp(word, OPCODE_NAMES[opcode]) != 0) {
+            opcode++;
+        }
+        if (opcode > 7) {
+            fprintf(stderr, "Unknown command: %s\n", word);
+            fclose(in);
+            return 2;
+        }
+        if (count == capacity) {
+            std::unique_ptr<Command[]> bigger(new Command[capacity * 2]);
+            for (int i = 0; i < count; ++i) {
+                bigger[i] = commands[i];
+            }
+            commands.swap(bigger);
+            capacity *= 2;
+        }
+        Command& command = commands[count++];
+        command.m_opcode = opcode;
+        command.m_args[0] = 0;
+        command.m_args[1] = 0;
+        for (int arg = 0; arg < OPCODE_ARITY[opcode]; ++arg) {
+            if (fscanf(in, "%d", &command.m_args[arg]) != 1) {
+                fprintf(stderr, "Invalid input format\n");
+                fclose(in);
+                return 2;
+            }
+        }
+        // Team IDs: add_team / merge_teams / get_team_record args, add_jockey's second
+        bool teamArgs = opcode == 1 || opcode == 4 || opcode == 7;
+        for (int arg = 0; arg < OPCODE_ARITY[opcode]; ++arg) {
+            int value = command.m_args[arg];
+            bool isTeam = teamArgs || (opcode == 2 && arg == 1);
+            bool isJockey = (opcode == 2 && arg == 0) || opcode == 3 || opcode == 6;
+            if (isTeam && value > shape.m_max_team) {
+                shape.m_max_team = value;
+            }
+            if (isJockey && value > shape.m_max_jockey) {
+                shape.m_max_jockey = value;
+            }
+        }
+    }
+    fclose(in);
+
+    int status = 0;
+    for (int engine = 0; engine < ENGINE_COUNT; ++engine) {
+        CommandResult expected;
+        CommandResult actual;
+        char finding[FINDING_BYTES];
+        int divergence = first_divergence(engine, shape, commands.get(), count, &expected, &actual, finding);
+        if (divergence < 0) {
+            printf("%-16s OK (%d commands)\n", ENGINE_NAMES[engine], count);
+            continue;
+        }
+        printf("%-16s diverges at command %d: ", ENGINE_NAMES[engine], divergence + 1);
+        print_command(stdout, commands[divergence]);
+        print_divergence(stdout, expected, actual, finding);
+        status = 1;
+    }
+    return status;
+}
+
+int main(int argc, char** argv) {
+    double seconds = 10;
+    long long cases = 0;
+    int ops = 2000;
+    unsigned long long seed = 1;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+            return replay(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && hasValue) {
+            seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cases") == 0 && hasValue) {
+            cases = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--ops") == 0 && hasValue) {
+            ops = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && hasValue) {
+            seed = strtoull(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--seconds S] [--cases N] [--ops L] [--seed X] | --replay FILE\n", argv[0]);
+            return 2;
+        }
+    }
+    if (ops < 1) {
+        ops = 1;
+    }
+    return fuzz(seconds, cases, ops, seed);
+}
@@ -0,0 +1,175 @@
+// Deterministic generator of the scaling corpus (tests/scaling/corpus.json).
+// Writes ops commands in main.cpp's input format to stdout. The output is a
+// pure function of (mix, ops, seed), so only those three are checked in.
+//
+// Build: g++ -std=c++11 -O2 -DNDEBUG -I. tools/gen_corpus.cpp -o gen_corpus
+// Usage: ./gen_corpus <mix> <ops> <seed>
+//   mix: mixed    every operation, roughly in the proportions of the tests
+//        matches  update_match heavy, with rare merges: find_root under load
+//        merges   merge_teams / unite_by_record heavy: deep union-find trees
+// Or: python3 run_tests.py --scaling
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Percentages of the commands after the initial load, in opcode order:
+// add_team, add_jockey, update_match, merge_teams, unite_by_record,
+// get_jockey_record, get_team_record
+struct Mix {
+    const char* m_name;
+    int m_percent[7];
+};
+
+static const Mix MIXES[] = {
+    {"mixed",   {4, 12, 50, 8, 6, 10, 10}},
+    {"matches", {1, 2, 85, 1, 1, 5, 5}},
+    {"merges",  {2, 4, 44, 30, 10, 5, 5}},
+};
+static const int MIX_COUNT = sizeof(MIXES) / sizeof(MIXES[0]);
+
+// Buffered writer: the corpus reaches 10^8 lines
+class Output {
+private:
+    static const int BUFFER_BYTES = 1 << 16;
+    char m_buffer[BUFFER_BYTES];
+    int m_used;
+
+public:
+    Output() : m_used(0) {}
+
+    ~Output() {
+        flush();
+    }
+
+    void flush() {
+        fwrite(m_buffer, 1, m_used, stdout);
+        m_used = 0;
+    }
+
+    void command(const char* name, int arity, long long a, long long b) {
+        if (m_used > BUFFER_BYTES - 64) {
+            flush();
+        }
+        int length = static_cast<int>(strlen(name));
+        memcpy(m_buffer + m_used, name, length);
+        m_used += length;
+        number(a);
+        if (arity == 2) {
+            number(b);
+        }
+        m_buffer[m_used++] = '\n';
+    }
+
+    void number(long long value) {
+        char digits[24];
+        int count = 0;
+        m_buffer[m_used++] = ' ';
+        if (value < 0) {
+            m_buffer[m_used++] = '-';
+            value = -value;
+        }
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value);
+        while (count) {
+            m_buffer[m_used++] = digits[--count];
+        }
+    }
+};
+
+class Random {
+private:
+    unsigned long long m_state;
+
+public:
+    explicit Random(unsigned long long seed) : m_state(seed * 0x9E3779B97F4A7C15ull | 1) {}
+
+    unsigned long long next() {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return m_state;
+    }
+
+    // Uniform in [1, bound]
+    long long id(long long bound) {
+        return 1 + static_cast<long long>(next() % static_cast<unsigned long long>(bound));
+    }
+};
+
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s <mix> <ops> <seed>\n", argv[0]);
+        return 2;
+    }
+    const Mix* mix = nullptr;
+    for (int i = 0; i < MIX_COUNT; ++i) {
+        if (strcmp(argv[1], MIXES[i].m_name) == 0) {
+            mix = &MIXES[i];
+        }
+    }
+    long long ops = atoll(argv[2]);
+    if (!mix || ops <= 0) {
+        fprintf(stderr, "Unknown mix or bad operation count\n");
+        return 2;
+    }
+    Random random(strtoull(argv[3], nullptr, 10));
+    Output out;
+
+    // The initial population grows with the corpus, so the live population
+    // and the union-find trees scale with ops as well
+    long long teams = ops / 40 + 2;
+    long long jockeys = ops / 16 + 2;
+
+    long long emitted = 0;
+    for (long long team = 1; team <= teams && emitted < ops; ++team, ++emitted) {
+        out.command("add_team", 1, team, 0);
+    }
+    for (long long jockey = 1; jockey <= jockeys && emitted < ops; ++jockey, ++emitted) {
+        out.command("add_jockey", 2, jockey, random.id(teams));
+    }
+
+    // New IDs are handed out in order, with a few duplicates mixed in.
+    // Records stay small (matches are random), so unite_by_record asks for
+    // small records to find pairs.
+    long long nextTeam = teams + 1;
+    long long nextJockey = jockeys + 1;
+    for (; emitted < ops; ++emitted) {
+        int roll = static_cast<int>(random.next() % 100);
+        int opcode = 0;
+        while (opcode < 6 && roll >= mix->m_percent[opcode]) {
+            roll -= mix->m_percent[opcode];
+            opcode++;
+        }
+        switch (opcode) {
+            case 0:
+                out.command("add_team", 1, nextTeam++, 0);
+                break;
+            case 1:
+                if (random.next() % 10 == 0) {
+                    out.command("add_jockey", 2, random.id(nextJockey - 1), random.id(nextTeam - 1));
+                } else {
+                    out.command("add_jockey", 2, nextJockey++, random.id(nextTeam - 1));
+                }
+                break;
+            case 2:
+                out.command("update_match", 2, random.id(nextJockey - 1), random.id(nextJockey - 1));
+                break;
+            case 3:
+                out.command("merge_teams", 2, random.id(nextTeam - 1), random.id(nextTeam - 1));
+                break;
+            case 4:
+                out.command("unite_by_record", 1, random.id(8), 0);
+                break;
+            case 5:
+                out.command("get_jockey_record", 1, random.id(nextJockey - 1), 0);
+                break;
+            default:
+                out.command("get_team_record", 1, random.id(nextTeam - 1), 0);
+                break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+// NUMA placement report of a loaded Plains and LeagueRegistry.
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/numa_report.cpp LeagueRegistry.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o numa_report
+// Usage: ./numa_report [jockeys] [node]
+//
+// Pins the calling thread to node (default: the node it runs on), places both
+// structures there with set_numa_node, loads jockeys riders with worker
+// threads, merges and compacts, and prints one JSON placement report per
+// structure. On a single-node machine every sampled page is on node 0 and
+// the binding calls are no-ops, which is what CI checks.
+
+#include "LeagueRegistry.h"
+#include "plains25a2.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+int main(int argc, char** argv) {
+    int jockeys = argc > 1 ? atoi(argv[1]) : 1000000;
+    int node = argc > 2 ? atoi(argv[2]) : Numa::current_node();
+    if (jockeys <= 0 || node < 0 || node >= Numa::node_count()) {
+        fprintf(stderr, "Usage: %s [jockeys] [node below %d]\n", argv[0], Numa::node_count());
+        return 2;
+    }
+    bool pinned = Numa::pin_thread(pthread_self(), node);
+    fprintf(stderr, "%d node(s), placing on node %d, caller %s\n", Numa::node_count(), node,
+            pinned ? "pinned" : "not pinned");
+
+    int teams = jockeys / 16 + 1;
+    std::unique_ptr<Plains> plains(new Plains());
+    plains->set_worker_threads(ThreadPool::hardware_threads());
+    plains->set_numa_node(node);
+    for (int i = 1; i <= teams; ++i) {
+        plains->add_team(i);
+    }
+    for (int i = 1; i <= jockeys; ++i) {
+        plains->add_jockey(i, 1 + i % teams);
+    }
+    for (int i = 1; i + 1 <= teams; i += 2) {
+        plains->merge_teams(i, i + 1);
+    }
+    plains->compact_nodes();
+    plains->write_placement_report(std::cout);
+
+    std::unique_ptr<LeagueRegistry> registry(new LeagueRegistry());
+    registry->set_numa_node(node);
+    for (int league = 1; league <= 4; ++league) {
+        registry->create_league(league);
+        for (int i = 1; i <= teams; ++i) {
+            registry->add_team(league, i);
+        }
+        for (int i = 1; i <= jockeys / 4; ++i) {
+            registry->add_jockey(league, i, 1 + i % teams);
+        }
+    }
+    registry->write_placement_report(std::cout);
+    return 0;
+}
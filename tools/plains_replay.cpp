@@ -0,0 +1,380 @@
+// Replays Plains commands through the binary protocol (CommandProtocol.h).
+// Build: g++ -std=c++11 -O2 -DNDEBUG -pthread -I. tools/plains_replay.cpp CommandProtocol.cpp plains25a2.cpp ThreadPool.cpp SimdProbe.cpp -o plains_replay
+// Usage:
+//   ./plains_replay encode < commands.txt > commands.bin   text commands to binary
+//   ./plains_replay run < commands.bin > results.bin        binary commands to binary results
+//   ./plains_replay text < commands.txt                     text in, main.cpp's text out
+//   ./plains_replay pipeline < commands.txt                 same as text, with parsing, execution
+//                                                            and formatting on separate threads
+
+#include "CommandProtocol.h"
+#include "SpscRing.h"
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+
+static const int CHUNK_COMMANDS = 4096;
+static const int PIPELINE_BATCHES = 8;          // Batches in flight between the stages
+static const int MAX_LINE_BYTES = 64;           // Longest formatted result line
+
+struct OpcodeName {
+    const char* m_name;
+    Opcode m_opcode;
+    int m_arity;
+};
+
+static const OpcodeName OPCODE_NAMES[] = {
+    {"add_team", Opcode::ADD_TEAM, 1},
+    {"add_jockey", Opcode::ADD_JOCKEY, 2},
+    {"update_match", Opcode::UPDATE_MATCH, 2},
+    {"merge_teams", Opcode::MERGE_TEAMS, 2},
+    {"unite_by_record", Opcode::UNITE_BY_RECORD, 1},
+    {"get_jockey_record", Opcode::GET_JOCKEY_RECORD, 1},
+    {"get_team_record", Opcode::GET_TEAM_RECORD, 1},
+};
+static const int OPCODE_COUNT = sizeof(OPCODE_NAMES) / sizeof(OPCODE_NAMES[0]);
+
+static const char* const STATUS_NAMES[] = {
+    "SUCCESS", "ALLOCATION_ERROR", "INVALID_INPUT", "FAILURE"
+};
+
+enum ParseStatus {
+    PARSE_OK,
+    PARSE_END,
+    PARSE_UNKNOWN_COMMAND,
+    PARSE_BAD_FORMAT
+};
+
+// Whitespace separated words and ints from a FILE, read in large blocks
+class TextReader {
+private:
+    FILE* m_file;
+    char m_buffer[1 << 16];
+    int m_position;
+    int m_length;
+
+    int peek() {
+        if (m_position == m_length) {
+            m_length = static_cast<int>(fread(m_buffer, 1, sizeof(m_buffer), m_file));
+            m_position = 0;
+            if (m_length <= 0) {
+                m_length = 0;
+                return EOF;
+            }
+        }
+        return static_cast<unsigned char>(m_buffer[m_position]);
+    }
+
+    void skip_spaces() {
+        int c;
+        while ((c = peek()) == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            m_position++;
+        }
+    }
+
+public:
+    explicit TextReader(FILE* file) : m_file(file), m_position(0), m_length(0) {}
+
+    // Reads the next word (truncated to size - 1 chars); false at end of input
+    bool next_word(char* word, int size) {
+        skip_spaces();
+        int length = 0;
+        int c;
+        while ((c = peek()) != EOF && c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+            if (length < size - 1) {
+                word[length++] = static_cast<char>(c);
+            }
+            m_position++;
+        }
+        word[length] = '\0';
+        return length > 0;
+    }
+
+    bool next_int(int* value) {
+        skip_spaces();
+        bool negative = false;
+        int c = peek();
+        if (c == '-' || c == '+') {
+            negative = c == '-';
+            m_position++;
+            c = peek();
+        }
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        long long result = 0;
+        while ((c = peek()) >= '0' && c <= '9') {
+            result = result * 10 + (c - '0');
+            if (result > 2147483648LL) {
+                return false;
+            }
+            m_position++;
+        }
+        if (negative) {
+            result = -result;
+        }
+        if (result > 2147483647LL) {
+            return false;
+        }
+        *value = static_cast<int>(result);
+        return true;
+    }
+};
+
+// Reads the next text command. word receives the command name.
+static ParseStatus read_text_command(TextReader& reader, Command* command,
+                                     const OpcodeName** name, char* word, int wordSize) {
+    if (!reader.next_word(word, wordSize)) {
+        return PARSE_END;
+    }
+    for (int i = 0; i < OPCODE_COUNT; ++i) {
+        if (strcmp(word, OPCODE_NAMES[i].m_name) == 0) {
+            *name = &OPCODE_NAMES[i];
+            command->m_opcode = static_cast<int32_t>(OPCODE_NAMES[i].m_opcode);
+            command->m_args[0] = 0;
+            command->m_args[1] = 0;
+            for (int arg = 0; arg < OPCODE_NAMES[i].m_arity; ++arg) {
+                int value;
+                if (!reader.next_int(&value)) {
+                    return PARSE_BAD_FORMAT;
+                }
+                command->m_args[arg] = value;
+            }
+            return PARSE_OK;
+        }
+    }
+    return PARSE_UNKNOWN_COMMAND;
+}
+
+// Same messages as main.cpp
+static void print_parse_error(FILE* out, ParseStatus status, const char* word) {
+    if (status == PARSE_UNKNOWN_COMMAND) {
+        fprintf(out, "Unknown command: %s\n", word);
+    } else if (status == PARSE_BAD_FORMAT) {
+        fprintf(out, "Invalid input format\n");
+    }
+}
+
+static char* append_text(char* out, const char* text) {
+    while (*text) {
+        *out++ = *text++;
+    }
+    return out;
+}
+
+static char* append_int(char* out, int value) {
+    char digits[12];
+    int length = 0;
+    unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+    do {
+        digits[length++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0) {
+        *out++ = '-';
+    }
+    while (length) {
+        *out++ = digits[--length];
+    }
+    return out;
+}
+
+// Formats one result line the way main.cpp prints it; returns the end of the line
+static char* format_result(char* out, const OpcodeName* name, const CommandResult& result) {
+    out = append_text(out, name->m_name);
+    out = append_text(out, ": ");
+    out = append_text(out, STATUS_NAMES[result.m_status]);
+    bool hasAnswer = name->m_opcode == Opcode::GET_JOCKEY_RECORD ||
+                     name->m_opcode == Opcode::GET_TEAM_RECORD;
+    if (hasAnswer && result.m_status == static_cast<int32_t>(StatusType::SUCCESS)) {
+        out = append_text(out, ", ");
+        out = append_int(out, result.m_answer);
+    }
+    *out++ = '\n';
+    return out;
+}
+
+static int encode_text() {
+    TextReader reader(stdin);
+    unsigned char bytes[COMMAND_BYTES];
+    char word[32];
+    Command command;
+    const OpcodeName* name;
+    ParseStatus status;
+    while ((status = read_text_command(reader, &command, &name, word, sizeof(word))) == PARSE_OK) {
+        encode_command(command, bytes);
+        fwrite(bytes, 1, COMMAND_BYTES, stdout);
+    }
+    print_parse_error(stderr, status, word);
+    return status == PARSE_END ? 0 : 1;
+}
+
+static int run_binary() {
+    static unsigned char input[CHUNK_COMMANDS * COMMAND_BYTES];
+    static unsigned char output[CHUNK_COMMANDS * RESULT_BYTES];
+    Plains plains;
+    std::size_t pending = 0;
+    std::size_t got;
+    while ((got = fread(input + pending, 1, sizeof(input) - pending, stdin)) > 0) {
+        pending += got;
+        std::size_t consumed;
+        std::size_t count = execute_stream(plains, input, pending, output, sizeof(output), &consumed);
+        fwrite(output, RESULT_BYTES, count, stdout);
+        // Keep a partial command for the next read
+        memmove(input, input + consumed, pending - consumed);
+        pending -= consumed;
+    }
+    if (pending != 0) {
+        fprintf(stderr, "Truncated command at end of input\n");
+        return 1;
+    }
+    return 0;
+}
+
+// A block of commands travelling through the pipeline: the parser fills the
+// commands, the executor the results, the formatter prints and recycles it
+struct Batch {
+    Command m_commands[CHUNK_COMMANDS];
+    const OpcodeName* m_names[CHUNK_COMMANDS];
+    CommandResult m_results[CHUNK_COMMANDS];
+    int m_count;
+    ParseStatus m_status;       // How parsing ended after the last command
+    char m_word[32];            // Offending word for PARSE_UNKNOWN_COMMAND
+};
+
+// Parses the next batch; returns false once input ended or was invalid
+static bool parse_batch(TextReader& reader, Batch* batch) {
+    batch->m_count = 0;
+    batch->m_status = PARSE_OK;
+    while (batch->m_count < CHUNK_COMMANDS) {
+        int i = batch->m_count;
+        batch->m_status = read_text_command(reader, &batch->m_commands[i], &batch->m_names[i],
+                                            batch->m_word, sizeof(batch->m_word));
+        if (batch->m_status != PARSE_OK) {
+            return false;
+        }
+        batch->m_count++;
+    }
+    return true;
+}
+
+// Prints a finished batch; returns false if it ended with a parse error
+static bool format_batch(const Batch* batch, FILE* out) {
+    static char text[CHUNK_COMMANDS * MAX_LINE_BYTES];
+    char* end = text;
+    for (int i = 0; i < batch->m_count; ++i) {
+        end = format_result(end, batch->m_names[i], batch->m_results[i]);
+    }
+    fwrite(text, 1, end - text, out);
+    print_parse_error(out, batch->m_status, batch->m_word);
+    return batch->m_status == PARSE_OK || batch->m_status == PARSE_END;
+}
+
+static int run_text() {
+    TextReader reader(stdin);
+    Plains plains;
+    static Batch batch;
+    bool more = true;
+    while (more) {
+        more = parse_batch(reader, &batch);
+        execute_commands(plains, batch.m_commands, batch.m_count, batch.m_results);
+        if (!format_batch(&batch, stdout)) {
+            return 255;
+        }
+    }
+    return 0;
+}
+
+// Three stage pipeline. The parser and formatter get their own threads and
+// the calling thread is the executor, so only it ever touches the Plains.
+// Batches go parser -> executor -> formatter -> parser through SPSC rings;
+// every ring is FIFO, so output order matches input order.
+struct Pipeline {
+    SpscRing<Batch*> m_free;
+    SpscRing<Batch*> m_parsed;
+    SpscRing<Batch*> m_executed;
+    bool m_failed;
+
+    Pipeline() : m_free(PIPELINE_BATCHES), m_parsed(PIPELINE_BATCHES),
+                 m_executed(PIPELINE_BATCHES), m_failed(false) {}
+};
+
+static void* parser_main(void* arg) {
+    Pipeline* pipeline = static_cast<Pipeline*>(arg);
+    TextReader* reader = new TextReader(stdin);
+    Batch* batch;
+    while (pipeline->m_free.pop(batch)) {
+        bool more = parse_batch(*reader, batch);
+        pipeline->m_parsed.push(batch);
+        if (!more) {
+            break;
+        }
+    }
+    pipeline->m_parsed.close();
+    delete reader;
+    return nullptr;
+}
+
+static void* formatter_main(void* arg) {
+    Pipeline* pipeline = static_cast<Pipeline*>(arg);
+    Batch* batch;
+    while (pipeline->m_executed.pop(batch)) {
+        if (!format_batch(batch, stdout)) {
+            pipeline->m_failed = true;
+        }
+        pipeline->m_free.push(batch);
+    }
+    return nullptr;
+}
+
+static int run_pipeline() {
+    Batch* batches = new Batch[PIPELINE_BATCHES];
+    Pipeline pipeline;
+    for (int i = 0; i < PIPELINE_BATCHES; ++i) {
+        pipeline.m_free.push(&batches[i]);
+    }
+
+    // Without both helper threads fall back to the sequential loop; stdin
+    // is untouched until the parser starts
+    pthread_t formatter;
+    pthread_t parser;
+    if (pthread_create(&formatter, nullptr, &formatter_main, &pipeline) != 0) {
+        delete[] batches;
+        return run_text();
+    }
+    if (pthread_create(&parser, nullptr, &parser_main, &pipeline) != 0) {
+        pipeline.m_executed.close();
+        pthread_join(formatter, nullptr);
+        delete[] batches;
+        return run_text();
+    }
+
+    Plains plains;
+    Batch* batch;
+    while (pipeline.m_parsed.pop(batch)) {
+        execute_commands(plains, batch->m_commands, batch->m_count, batch->m_results);
+        pipeline.m_executed.push(batch);
+    }
+    pipeline.m_executed.close();
+    pthread_join(formatter, nullptr);
+    pthread_join(parser, nullptr);
+    delete[] batches;
+    return pipeline.m_failed ? 255 : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc == 2 && strcmp(argv[1], "encode") == 0) {
+        return encode_text();
+    }
+    if (argc == 2 && strcmp(argv[1], "run") == 0) {
+        return run_binary();
+    }
+    if (argc == 2 && strcmp(argv[1], "text") == 0) {
+        return run_text();
+    }
+    if (argc == 2 && strcmp(argv[1], "pipeline") == 0) {
+        return run_pipeline();
+    }
+    fprintf(stderr, "Usage: %s encode|run|text|pipeline\n", argv[0]);
+    return 2;
+}